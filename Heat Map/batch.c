@@ -0,0 +1,470 @@
+/**
+ * @file batch.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief solve many input files at the same time on the thread pool, each one to its own output file
+ */
+#define _POSIX_C_SOURCE 200809L
+
+// ------------------------------ includes --------------------------------
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "batch.h"
+#include "heat_eqn.h"
+#include "pool.h"
+#include "reader.h"
+
+// -------------------------- const definitions -------------------------
+#define OUTPUT_SUFFIX ".out"
+#define ERROR_MEMORY "Memory allocation failed.\n"
+#define ERROR_DIRECTORY "Error reading the directory %s.\n"
+#define ERROR_INPUT "Error opening %s.\n"
+#define ERROR_OUTPUT "Error writing %s.\n"
+#define ERROR_PARSE "%s: %s\n"
+#define ERROR_BATCH_OPTION "Error with option: --%s can't be used with several inputs.\n"
+#define ERROR_SAME_NAME "Error with inputs: %s and %s would have the same output in %s.\n"
+#define OUTPUT_MODE 0644
+
+/**
+ * the inputs of a batch, taken in turn by the workers
+ */
+typedef struct Batch
+{
+    const SolverOptions *options;
+    char **inputs;
+    size_t count;
+    size_t next;
+    int failed;
+    pthread_mutex_t lock;
+} Batch;
+
+/**
+ * what a worker keeps from one input to the next
+ */
+typedef struct BatchWorker
+{
+    HeatInput input;
+    Grid grid;
+    FloatGrid single;
+    SolverWorkspace workspace;
+    Output out;
+} BatchWorker;
+
+// ------------------------------ functions -------------------------------
+/**
+ * tell if a path is a directory
+ * @param path the path
+ * @return 1 if it is and 0 if not
+ */
+static int isDirectory(const char *path)
+{
+    struct stat info;
+    return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+/**
+ * tell if ex3 has to run in batch mode: several inputs, or a directory
+ * @param inputs the input arguments
+ * @param count number of inputs
+ * @return 1 if it does and 0 if not
+ */
+int isBatch(char *inputs[], int count)
+{
+    return count > 1 || (count == 1 && isDirectory(inputs[0]));
+}
+
+/**
+ * join a directory and a name
+ * @param directory the directory
+ * @param name the name
+ * @param suffix added after the name
+ * @return the path, to free, NULL if there is not enough memory
+ */
+static char *joinPath(const char *directory, const char *name, const char *suffix)
+{
+    size_t length = (directory != NULL ? strlen(directory) + 1 : 0) + strlen(name) + strlen(suffix) + 1;
+    char *path = (char *) malloc(length);
+    if (path != NULL)
+    {
+        snprintf(path, length, "%s%s%s%s", directory != NULL ? directory : "", directory != NULL ? "/" : "", name,
+                 suffix);
+    }
+    return path;
+}
+
+/**
+ * the name of a file without its directory
+ * @param path the path of the file
+ * @return the name, in path
+ */
+static const char *baseName(const char *path)
+{
+    const char *name = strrchr(path, '/');
+    return name != NULL ? name + 1 : path;
+}
+
+/**
+ * compare two paths, for qsort
+ * @param a the first path
+ * @param b the second path
+ * @return as strcmp
+ */
+static int comparePaths(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/**
+ * compare the names of two paths without their directories, for qsort
+ * @param a the first path
+ * @param b the second path
+ * @return as strcmp
+ */
+static int compareBaseNames(const void *a, const void *b)
+{
+    return strcmp(baseName(*(char *const *) a), baseName(*(char *const *) b));
+}
+
+/**
+ * tell if an option which has no meaning for several inputs is set, and report it
+ * @param options the options
+ * @return 1 if one is and 0 if not
+ */
+static int checkBatchOptions(const SolverOptions *options)
+{
+    const char *option = options->format != FORMAT_TEXT ? "format"
+                         : options->outOfCore != NULL ? "out-of-core"
+                         : options->checkpoint != NULL ? "checkpoint"
+                         : options->warmStart != NULL ? "warm-start"
+                         : options->save != NULL ? "save" : NULL;
+    if (option != NULL)
+    {
+        fprintf(stderr, ERROR_BATCH_OPTION, option);
+    }
+    return option != NULL;
+}
+
+/**
+ * tell if two inputs have the same name, and so the same output in the output directory, and report them
+ * @param batch the batch
+ * @param directory the output directory
+ * @return 1 if two have (or there is not enough memory to check) and 0 if not
+ */
+static int checkSameNames(const Batch *batch, const char *directory)
+{
+    char **sorted = (char **) malloc(sizeof(char *) * (batch->count + 1));
+    if (sorted == NULL)
+    {
+        fprintf(stderr, ERROR_MEMORY);
+        return 1;
+    }
+    memcpy(sorted, batch->inputs, sizeof(char *) * batch->count);
+    qsort(sorted, batch->count, sizeof(char *), compareBaseNames);
+    int same = 0;
+    for (size_t i = 1; i < batch->count && !same; ++i)
+    {
+        if (strcmp(baseName(sorted[i - 1]), baseName(sorted[i])) == 0)
+        {
+            fprintf(stderr, ERROR_SAME_NAME, sorted[i - 1], sorted[i], directory);
+            same = 1;
+        }
+    }
+    free(sorted);
+    return same;
+}
+
+/**
+ * add a path to the inputs of a batch
+ * @param batch the batch
+ * @param path the path, owned by the batch from now on
+ * @param room number of paths inputs has room for, updated when it grows
+ * @return 0 if it's work and 1 if not
+ */
+static int addInput(Batch *batch, char *path, size_t *room)
+{
+    if (path == NULL)
+    {
+        return 1;
+    }
+    if (batch->count == *room)
+    {
+        size_t grown = *room > 0 ? *room * 2 : 16;
+        char **inputs = (char **) realloc(batch->inputs, sizeof(char *) * grown);
+        if (inputs == NULL)
+        {
+            free(path);
+            return 1;
+        }
+        batch->inputs = inputs;
+        *room = grown;
+    }
+    batch->inputs[batch->count++] = path;
+    return 0;
+}
+
+/**
+ * add the files of a directory to the inputs, sorted by name, without the hidden files and the outputs
+ * @param batch the batch
+ * @param directory the directory
+ * @param room number of paths inputs has room for, updated when it grows
+ * @return 0 if it's work and 1 if not
+ */
+static int addDirectory(Batch *batch, const char *directory, size_t *room)
+{
+    DIR *dir = opendir(directory);
+    size_t first = batch->count, suffix = strlen(OUTPUT_SUFFIX);
+    struct dirent *entry;
+    if (dir == NULL)
+    {
+        fprintf(stderr, ERROR_DIRECTORY, directory);
+        return 1;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        const char *name = entry->d_name;
+        size_t length = strlen(name);
+        if (name[0] == '.' || (length >= suffix && strcmp(name + length - suffix, OUTPUT_SUFFIX) == 0))
+        { // the outputs of an earlier batch are not inputs
+            continue;
+        }
+        char *path = joinPath(directory, name, "");
+        if (path != NULL && isDirectory(path))
+        {
+            free(path);
+            continue;
+        }
+        if (addInput(batch, path, room))
+        {
+            closedir(dir);
+            fprintf(stderr, ERROR_MEMORY);
+            return 1;
+        }
+    }
+    closedir(dir);
+    qsort(batch->inputs + first, batch->count - first, sizeof(char *), comparePaths);
+    return 0;
+}
+
+/**
+ * calculate the parsed input of the worker and print it to its output, like ex3 does
+ * @param options the options
+ * @param worker the worker
+ * @return HEAT_OK or the error
+ */
+static int solveInput(const SolverOptions *options, BatchWorker *worker)
+{
+    const HeatInput *input = &worker->input;
+    double delta, terminate = input->terminate;
+    if (options->precision != PRECISION_DOUBLE)
+    {
+        if (resizeFloatGrid(&worker->single, (size_t) input->n, (size_t) input->m))
+        {
+            return HEAT_ERROR_MEMORY;
+        }
+        for (int i = 0; i < input->numSources; ++i)
+        {
+            GRID_AT(&worker->single, input->sources[i].x, input->sources[i].y) = (float) input->sources[i].value;
+        }
+        do
+        {
+            int error = tryCalculateFloatGrid(heat_eqn, &worker->single, input->sources, (size_t) input->numSources,
+                                              terminate, input->n_iter, input->is_cyclic, options, &delta);
+            if (error != HEAT_OK)
+            {
+                return error;
+            }
+            printFloatGrid(&worker->out, &worker->single, delta);
+        } while (delta > terminate || -delta > terminate);
+        return HEAT_OK;
+    }
+    if (resizeGrid(&worker->grid, (size_t) input->n, (size_t) input->m))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    placeSources(&worker->grid, input->sources, input->numSources);
+    do
+    {
+        int error = tryCalculateGrid(heat_eqn, &worker->grid, input->sources, (size_t) input->numSources,
+                                     terminate, input->n_iter, input->is_cyclic, options, &delta);
+        if (error != HEAT_OK)
+        {
+            return error;
+        }
+        printGrid(&worker->out, &worker->grid, delta);
+    } while (delta > terminate || -delta > terminate);
+    return HEAT_OK;
+}
+
+/**
+ * parse, calculate and print one input into its output file. An input which can't be parsed is reported and has no
+ * output, the other inputs go on.
+ * @param options the options
+ * @param worker the worker
+ * @param input the input file
+ * @return 0 if it's work and 1 if not
+ */
+static int runInput(const SolverOptions *options, BatchWorker *worker, const char *input)
+{
+    char *output = options->outputDir != NULL ? joinPath(options->outputDir, baseName(input), OUTPUT_SUFFIX)
+                                              : joinPath(NULL, input, OUTPUT_SUFFIX);
+    if (output == NULL)
+    {
+        fprintf(stderr, ERROR_MEMORY);
+        return 1;
+    }
+    FILE *fp = fopen(input, "r");
+    if (fp == NULL)
+    {
+        fprintf(stderr, ERROR_INPUT, input);
+        free(output);
+        return 1;
+    }
+    int error = readInput(fp, &worker->input);
+    fclose(fp);
+    if (error != HEAT_OK)
+    {
+        fprintf(stderr, ERROR_PARSE, input, statusMessage(error));
+        free(output);
+        return 1;
+    }
+    worker->out.fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, OUTPUT_MODE);
+    if (worker->out.fd < 0)
+    {
+        fprintf(stderr, ERROR_OUTPUT, output);
+        free(output);
+        return 1;
+    }
+    worker->out.failed = 0;
+    error = solveInput(options, worker);
+    if (error != HEAT_OK)
+    {
+        fprintf(stderr, ERROR_PARSE, input, statusMessage(error));
+    }
+    int failed = error != HEAT_OK;
+    int written = flushOutput(&worker->out) == 0;
+    if ((close(worker->out.fd) != 0 || !written) && !failed)
+    {
+        fprintf(stderr, ERROR_OUTPUT, output);
+        failed = 1;
+    }
+    free(output);
+    return failed;
+}
+
+/**
+ * body of a worker of the batch: take the next input until there is none left
+ * @param arg the batch
+ * @param worker the number of the worker
+ * @param workers number of workers
+ */
+static void batchWorker(void *arg, int worker, int workers)
+{
+    Batch *batch = (Batch *) arg;
+    BatchWorker local;
+    SolverOptions options = *batch->options;
+    (void) worker;
+    (void) workers;
+
+    options.threads = 1; // the inputs are spread on the workers, each one is calculated by one thread
+    options.processes = 1;
+    options.sweeps = NULL;
+    memset(&local.input, 0, sizeof(HeatInput));
+    memset(&local.workspace, 0, sizeof(SolverWorkspace));
+    options.workspace = &local.workspace;
+    local.grid.block = NULL;
+    local.single.block = NULL;
+    if (openOutput(&local.out, -1, OUTPUT_BUFFER_SIZE))
+    { // the other workers take the inputs
+        fprintf(stderr, ERROR_MEMORY);
+        pthread_mutex_lock(&batch->lock);
+        batch->failed = 1;
+        pthread_mutex_unlock(&batch->lock);
+        return;
+    }
+    for (;;)
+    {
+        pthread_mutex_lock(&batch->lock);
+        size_t next = batch->next < batch->count ? batch->next++ : batch->count;
+        pthread_mutex_unlock(&batch->lock);
+        if (next == batch->count)
+        {
+            break;
+        }
+        if (runInput(&options, &local, batch->inputs[next]))
+        {
+            pthread_mutex_lock(&batch->lock);
+            batch->failed = 1;
+            pthread_mutex_unlock(&batch->lock);
+        }
+    }
+    closeOutput(&local.out);
+    freeInput(&local.input);
+    freeWorkspace(&local.workspace);
+    freeGrid(&local.grid);
+    freeFloatGrid(&local.single);
+}
+
+/**
+ * solve the input files, and the files of the input directories, options->jobs of them at the same time
+ * @param options the options
+ * @param inputs the input files and directories
+ * @param count number of inputs
+ * @return 0 if it's work and 1 if an input or an output failed
+ */
+int runBatch(const SolverOptions *options, char *inputs[], int count)
+{
+    Batch batch = {options, NULL, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+    size_t room = 0;
+    int failed = checkBatchOptions(options);
+
+    for (int i = 0; i < count && !failed; ++i)
+    {
+        if (isDirectory(inputs[i]))
+        {
+            failed = addDirectory(&batch, inputs[i], &room);
+        }
+        else if (addInput(&batch, joinPath(NULL, inputs[i], ""), &room))
+        {
+            fprintf(stderr, ERROR_MEMORY);
+            failed = 1;
+        }
+    }
+    if (!failed && options->outputDir != NULL)
+    {
+        failed = checkSameNames(&batch, options->outputDir);
+    }
+    int jobs = options->jobs;
+    if (jobs == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cpus > 0 ? (int) cpus : 1;
+    }
+    if (batch.count < (size_t) jobs)
+    {
+        jobs = batch.count > 0 ? (int) batch.count : 1;
+    }
+    Pool *pool = NULL;
+    if (!failed && startPool(&pool, jobs))
+    { // the inputs are solved one after the other
+        failed = startPool(&pool, 1);
+    }
+    if (!failed)
+    {
+        runPool(pool, batchWorker, &batch);
+        failed = batch.failed;
+    }
+    stopPool(&pool);
+    for (size_t i = 0; i < batch.count; ++i)
+    {
+        free(batch.inputs[i]);
+    }
+    free(batch.inputs);
+    return failed;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file batch.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief solve many input files at the same time, each one to its own output file
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+// ------------------------------ includes --------------------------------
+#include "solver.h"
+
+// ------------------------------ functions -------------------------------
+/**
+ * tell if ex3 has to run in batch mode: several inputs, or a directory
+ * @param inputs the input arguments
+ * @param count number of inputs
+ * @return 1 if it does and 0 if not
+ */
+int isBatch(char *inputs[], int count);
+
+/**
+ * solve the input files, and the files of the input directories (sorted by name, the hidden ones and the .out ones
+ * left out), options->jobs of them at the same time on the thread pool. Each input is calculated and printed like ex3
+ * does, into the file named after it with .out added, in options->outputDir or next to the input. Each worker keeps
+ * its grid, its input and its output buffers from one input to the next, so they are only allocated again for a larger
+ * grid. The inputs are calculated by one thread each. The options which have no meaning for several inputs (format,
+ * out-of-core, checkpoint, warm-start and save), and two inputs of the same name with an output directory, are
+ * reported and nothing is solved. An input which can't be parsed or solved is reported on stderr with its name and
+ * the others go on.
+ * @param options the options
+ * @param inputs the input files and directories
+ * @param count number of inputs
+ * @return 0 if it's work and 1 if an input or an output failed
+ */
+int runBatch(const SolverOptions *options, char *inputs[], int count);
+
+#endif //BATCH_H
@@ -0,0 +1,232 @@
+/**
+ * @file bench.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief heatbench: time the parsing, the calculation and the printing of input files and report them as JSON
+ */
+#define _POSIX_C_SOURCE 200112L
+
+// ------------------------------ includes --------------------------------
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "heat_eqn.h"
+#include "profile.h"
+#include "reader.h"
+#include "solver.h"
+
+// -------------------------- const definitions -------------------------
+#define USAGE "Usage: heatbench [--option=value ...] <input file> ...\n"
+#define ERROR_MEMORY "Memory allocation failed."
+#define ERROR_OPEN "Error opening %s.\n"
+#define BENCH_FORMAT 1
+#define NULL_DEVICE "/dev/null"
+#define ACCESSES_PER_POINT 2
+
+/**
+ * what is measured for one input, the times in seconds
+ */
+typedef struct BenchResult
+{
+    int n;
+    int m;
+    int numSource;
+    int is_cyclic;
+    unsigned int n_iter;
+    double parseTime;
+    double calculateTime;
+    double printTime;
+    unsigned long sweeps;
+    unsigned long calls;
+    double delta;
+} BenchResult;
+
+// ------------------------------ functions -------------------------------
+/**
+ * read the monotonic clock
+ * @return the time in seconds
+ */
+static double now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+}
+
+/**
+ * print a string as a JSON string
+ * @param value the string
+ */
+static void printJsonString(const char *value)
+{
+    putchar('"');
+    for (; *value != '\0'; ++value)
+    {
+        unsigned char c = (unsigned char) *value;
+        if (c == '"' || c == '\\')
+        {
+            printf("\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            printf("\\u%04x", c);
+        }
+        else
+        {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+/**
+ * calculate a parsed input like ex3 does, the grids printed to out
+ * @param options the options
+ * @param out the output
+ * @param listSources list of source
+ * @param result the input, set to the measures of the calculation and of the printing
+ */
+static void benchGrid(SolverOptions *options, Output *out, source_point *listSources, double terminate,
+                      BenchResult *result)
+{
+    Grid grid;
+    FloatGrid single;
+    int isFloat = options->precision != PRECISION_DOUBLE;
+    double delta, start = now();
+
+    if (isFloat ? initFloatGrid(&single, (size_t) result->n, (size_t) result->m)
+                : initGrid(&grid, (size_t) result->n, (size_t) result->m))
+    {
+        fprintf(stderr, ERROR_MEMORY);
+        closeAndFree(NULL, NULL, listSources, NULL);
+    }
+    for (int i = 0; i < result->numSource && isFloat; ++i)
+    {
+        GRID_AT(&single, listSources[i].x, listSources[i].y) = (float) listSources[i].value;
+    }
+    if (!isFloat)
+    {
+        placeSources(&grid, listSources, result->numSource);
+    }
+    result->parseTime += now() - start;
+    options->sweeps = &result->sweeps;
+    do
+    {
+        start = now();
+        delta = isFloat ? calculateFloatGrid(heat_eqn, &single, listSources, (size_t) result->numSource, terminate,
+                                             result->n_iter, result->is_cyclic, options)
+                        : calculateGrid(heat_eqn, &grid, listSources, (size_t) result->numSource, terminate,
+                                        result->n_iter, result->is_cyclic, options);
+        double middle = now();
+        if (isFloat)
+        {
+            printFloatGrid(out, &single, delta);
+        }
+        else
+        {
+            printGrid(out, &grid, delta);
+        }
+        result->calculateTime += middle - start;
+        result->printTime += now() - middle;
+        ++result->calls;
+    } while (delta > terminate || -delta > terminate);
+    result->delta = delta;
+    options->sweeps = NULL;
+    if (isFloat)
+    {
+        freeFloatGrid(&single);
+    }
+    else
+    {
+        freeGrid(&grid);
+    }
+}
+
+/**
+ * print the measures of an input as a JSON object
+ * @param path the input file
+ * @param result the measures
+ * @param pointBytes size of a point of the grid
+ */
+static void printResult(const char *path, const BenchResult *result, size_t pointBytes)
+{
+    double updates = (double) result->sweeps * (double) result->n * (double) result->m;
+    double seconds = result->calculateTime > 0 ? result->calculateTime : 1e-9;
+    printf("    {\"input\": ");
+    printJsonString(path);
+    printf(", \"n\": %d, \"m\": %d, \"sources\": %d, \"is_cyclic\": %d, \"n_iter\": %u,\n", result->n, result->m,
+           result->numSource, result->is_cyclic, result->n_iter);
+    printf("     \"parse_seconds\": %.6f, \"calculate_seconds\": %.6f, \"print_seconds\": %.6f,\n", result->parseTime,
+           result->calculateTime, result->printTime);
+    printf("     \"calls\": %lu, \"sweeps\": %lu, \"delta\": %.9g, \"cells_per_second\": %.6g,\n", result->calls,
+           result->sweeps, result->delta, updates / seconds);
+    printf("     \"bandwidth_bytes_per_second\": %.6g}", updates * ACCESSES_PER_POINT * (double) pointBytes / seconds);
+}
+
+/**
+ * The main function: run each input like ex3 would, the grids printed to /dev/null, and print the measures as JSON
+ * The bandwidth counts a read and a write of each point per sweep, the least a sweep moves to and from the memory.
+ * @param argc
+ * @param argv the options, as for ex3, then the input files
+ * @return 0 if it's work and 1 if not
+ */
+int main(int argc, char *argv[])
+{
+    SolverOptions options;
+    Output out;
+    int first;
+
+    defaultOptions(&options);
+    if (readOptionsFromEnv(&options) || readOptionsFromArgs(&options, argc, argv, &first) ||
+        checkOptions(&options))
+    {
+        return 1;
+    }
+    initProfile(options.profile);
+    if (first >= argc)
+    {
+        fprintf(stderr, USAGE);
+        return 1;
+    }
+    int sink = open(NULL_DEVICE, O_WRONLY);
+    if (sink < 0 || openOutput(&out, sink, OUTPUT_BUFFER_SIZE))
+    {
+        fprintf(stderr, ERROR_OPEN, NULL_DEVICE);
+        return 1;
+    }
+    printf("{\"format\": %d,\n \"options\": [", BENCH_FORMAT);
+    for (int i = 1; i < first; ++i)
+    {
+        printJsonString(argv[i]);
+        printf(i + 1 < first ? ", " : "");
+    }
+    printf("],\n \"results\": [\n");
+    for (int i = first; i < argc; ++i)
+    {
+        BenchResult result = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        source_point *listSources;
+        double terminate;
+        FILE *fp = fopen(argv[i], "r");
+        if (fp == NULL)
+        {
+            fprintf(stderr, ERROR_OPEN, argv[i]);
+            return 1;
+        }
+        double start = now();
+        parseFile(fp, &result.n, &result.m, &listSources, &result.numSource, &terminate, &result.n_iter,
+                  &result.is_cyclic);
+        fclose(fp);
+        result.parseTime = now() - start;
+        benchGrid(&options, &out, listSources, terminate, &result);
+        free(listSources);
+        printResult(argv[i], &result, options.precision != PRECISION_DOUBLE ? sizeof(float) : sizeof(double));
+        printf(i + 1 < argc ? ",\n" : "\n");
+        fflush(stdout);
+    }
+    printf(" ]}\n");
+    closeOutput(&out);
+    return 0;
+}
@@ -8,158 +8,358 @@
 
 // ------------------------------ includes --------------------------------
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "calculator.h"
+#include "gridfile.h"
+#include "profile.h"
+#include "solver.h"
+#include "stencil.h"
+#include "sum.h"
+#include "sweep.h"
+
+// -------------------------- const definitions -------------------------
+#define ERROR_CHECKPOINT "Error writing the checkpoint.\n"
+
 // ------------------------------ functions -------------------------------
 /**
- * find the neighbour of (x,y) if it's cyclic
+ * get room for the row cursors of a sweep, in the workspace if there is one
+ * @param workspace the workspace, NULL to allocate the cursors
+ * @param rows number of cursors
+ * @return the cursors, NULL if there is not enough memory
+ */
+static const int **reserveCursor(SolverWorkspace *workspace, size_t rows)
+{
+    if (workspace == NULL)
+    {
+        return (const int **) malloc(sizeof(int *) * rows);
+    }
+    if (workspace->cursor == NULL || workspace->cursorRows < rows)
+    {
+        free(workspace->cursor);
+        workspace->cursor = (const int **) malloc(sizeof(int *) * rows);
+        workspace->cursorRows = workspace->cursor != NULL ? rows : 0;
+    }
+    return workspace->cursor;
+}
+
+/**
+ * give back the row cursors of a sweep, they are kept if they are the ones of the workspace
+ * @param workspace the workspace, NULL if the cursors were allocated
+ * @param cursor the cursors
+ */
+static void releaseCursor(SolverWorkspace *workspace, const int **cursor)
+{
+    if (workspace == NULL)
+    {
+        free(cursor);
+    }
+}
+
+/**
+ * free the memory of a workspace
+ * @param workspace the workspace
+ */
+void freeWorkspace(SolverWorkspace *workspace)
+{
+    freeSourceIndex(&workspace->index);
+    free(workspace->cursor);
+    workspace->cursor = NULL;
+    workspace->cursorRows = 0;
+    stopPool(&workspace->pool);
+}
+
+/**
+ * Same as calculateGrid() but returns an error instead of printing it and exiting.
+ * @param function function that calculate the temperature of a coordinate
  * @param grid the grid
- * @param right right neighbour
- * @param top top neighbour
- * @param left left neighbour
- * @param bottom bottom neighbour
- * @param x x coordinate
- * @param y y coordinate
- * @param n width
- * @param m length
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param options how to sweep, NULL for the default options
+ * @param result set to the difference between the sums of the two last sweeps
+ * @return HEAT_OK, HEAT_ERROR_MEMORY, HEAT_ERROR_HALO or HEAT_ERROR_STOPPED (result is then the one of the last sweep)
  */
-void cyclic(double **grid, double *right, double *top, double *left, double *bottom, int x, int y, int n, int m)
+int tryCalculateGrid(diff_func function, Grid *grid, source_point *sources, size_t num_sources, double terminate,
+                     unsigned int n_iter, int is_cyclic, const SolverOptions *options, double *result)
 {
-    if (x == 0)
+    double sum = 0, previousSum = 0;
+    SweepState state;
+    SolverOptions defaults;
+    ActiveTiles active;
+    ProfileMark call, mark;
+    if (profileLevel)
     {
-        *top = grid[n - 1][y];
+        profileMark(&call);
     }
-    else
+    if (options == NULL)
     {
-        *top = grid[x - 1][y];
+        defaultOptions(&defaults);
+        options = &defaults;
     }
-    if (y == 0)
+    state.function = function;
+    state.grid = grid;
+    state.is_cyclic = is_cyclic;
+    state.halo = grid->halo && options->boundary == BOUNDARY_HALO;
+    state.tileRows = grid->n;
+    state.tileCols = grid->m;
+    state.cursor = NULL;
+    state.active = NULL;
+    state.rowSums = NULL;
+    state.stream = 0;
+    state.stencil = options->stencil;
+    state.simd = options->simd;
+    state.blockSweeps = options->blockSweeps;
+    state.blockCols = 0;
+    state.firstRow = 0;
+    const Stencil *stencil = findStencil(options->stencil);
+    state.run = stencil->run;
+    state.relax = stencil->relax;
+    if (stencil->function != NULL)
     {
-        *left = grid[x][m - 1];
+        state.function = stencil->function;
     }
-    else
+    int order = options->order, threads = options->threads, processes = options->processes;
+    // the diagonal stencils keep the column order below, which is not streamed
+    int stream = grid->mapped > 0 && !stencil->diagonals;
+    if (stream)
+    { // the grid is swept in bands of full rows, in the order of its file
+        order = ORDER_TILED;
+        threads = 1;
+        processes = 1;
+    }
+    if ((threads > 1 || processes != 1) && grid->halo)
+    { // the bands of rows can only be calculated at the same time in the red-black order
+        order = ORDER_RED_BLACK;
+    }
+    if (stencil->diagonals)
+    { // only the column order refreshes the ghost copies the diagonals read
+        if (!grid->halo)
+        {
+            return HEAT_ERROR_HALO;
+        }
+        order = ORDER_COLUMN;
+        state.halo = 1;
+    }
+    int multigrid = n_iter == 0 && options->solver == SOLVER_MULTIGRID && grid->halo && !stencil->diagonals &&
+                    (!is_cyclic || num_sources > 0) && !stream;
+    // the over-relaxed sweeps smooth the grid badly, the multigrid cycles smooth it with the plain sweep
+    state.omega = multigrid ? OMEGA_GAUSS_SEIDEL : chooseOmega(options->omega, grid->n, grid->m, is_cyclic,
+                                                                options->stencil);
+    double threshold = options->activeThreshold;
+    if (options->changes != NULL && threshold < 0)
+    { // the points moving slower than that can't move the sum by terminate
+        threshold = terminate / (double) (grid->n * grid->m > 0 ? grid->n * grid->m : 1);
+    }
+    // the multigrid corrections would move the points of the tiles behind their back
+    int skipTiles = threshold >= 0 && order != ORDER_RED_BLACK && !stencil->diagonals && !multigrid && !stream;
+    if (skipTiles)
+    { // the tiled order calculates the same grid as the row and column ones
+        order = ORDER_TILED;
+    }
+    double (*sweep)(SweepState *) = state.halo ? calculateOneHalo : calculateOne;
+    if (order == ORDER_TILED)
     {
-        *left = grid[x][y - 1];
+        state.tileRows = options->tileRows;
+        state.tileCols = options->tileCols;
+        if (stream)
+        {
+            state.tileCols = grid->m;
+            chooseStreamRows(&state.tileRows, sizeof(double) * grid->stride);
+            state.stream = 1;
+        }
+        else if (skipTiles)
+        {
+            chooseActiveTile(&state.tileRows, &state.tileCols);
+        }
+        else
+        {
+            chooseTile(&state.tileRows, &state.tileCols);
+        }
     }
-    if (x == n - 1)
+    SolverWorkspace *workspace = options->workspace;
+    if (order != ORDER_COLUMN)
     {
-        *bottom = grid[0][y];
+        sweep = calculateOneTiled;
+        state.cursor = reserveCursor(workspace, state.tileRows + 1);
     }
-    else
+    if (order == ORDER_RED_BLACK && grid->halo)
     {
-        *bottom = grid[x + 1][y];
+        sweep = calculateOneRedBlack;
+        state.halo = 1;
     }
-    if (y == m - 1)
+    if (skipTiles)
     {
-        *right = grid[x][0];
+        sweep = calculateOneActive;
+        state.active = &active;
     }
-    else
+    int byColumn = order == ORDER_COLUMN ? SOURCES_BY_COLUMN : SOURCES_BY_ROW;
+    if (order != ORDER_COLUMN && state.cursor == NULL)
     {
-        *right = grid[x][y + 1];
+        return HEAT_ERROR_MEMORY;
     }
-}
-
-/**
- * find the neighbour of (x,y) if it's cyclic
- * @param grid the grid
- * @param right right neighbour
- * @param top top neighbour
- * @param left left neighbour
- * @param bottom bottom neighbour
- * @param x x coordinate
- * @param y y coordinate
- * @param n width
- * @param m length
- */
-void notCyclic(double **grid, double *right, double *top, double *left, double *bottom, int x, int y, int n, int m)
-{
-    if (x == 0)
+    double *rowSums = NULL;
+    if (options->sum == SUM_PAIRWISE)
     {
-        *top = 0;
+        rowSums = (double *) malloc(sizeof(double) * (grid->n > 0 ? grid->n : 1));
+        if (rowSums == NULL)
+        {
+            releaseCursor(workspace, state.cursor);
+            return HEAT_ERROR_MEMORY;
+        }
     }
-    else
+    if (sweep == calculateOneRedBlack)
+    { // the red-black sweeps sum the rows as they finish them
+        state.rowSums = rowSums;
+    }
+    if (skipTiles && initActiveTiles(&active, grid->n, grid->m, state.tileRows, state.tileCols, threshold))
     {
-        *top = grid[x - 1][y];
+        releaseCursor(workspace, state.cursor);
+        free(rowSums);
+        return HEAT_ERROR_MEMORY;
     }
-    if (y == 0)
+    if (skipTiles && options->changes != NULL)
     {
-        *left = 0;
+        seedActiveTiles(&active, grid, options->changes, options->numChanges, state.tileRows, state.tileCols);
     }
-    else
+    if (workspace != NULL ? rebuildSourceIndex(&workspace->index, sources, num_sources, grid->n, grid->m, byColumn)
+                          : buildSourceIndex(&state.index, sources, num_sources, grid->n, grid->m, byColumn))
     {
-        *left = grid[x][y - 1];
+        releaseCursor(workspace, state.cursor);
+        free(rowSums);
+        if (skipTiles)
+        {
+            freeActiveTiles(&active);
+        }
+        return HEAT_ERROR_MEMORY;
     }
-    if (x == n - 1)
+    if (workspace != NULL)
     {
-        *bottom = 0;
+        state.index = workspace->index;
     }
-    else
+    unsigned long done = options->resumeSweeps;
+    double delta = options->resumeDelta;
+    sum = options->resumeSum; // a call resumed from a checkpoint goes on after the sweep done
+    int plain = done == 0 && options->checkpoint == NULL, finished = 0, stopped = 0, told = 0;
+    if (plain && multigrid)
+    { // the sweeps go on from the last cycle if the cycles stopped before terminate
+        done = calculateMultigrid(&state, sweep, sources, num_sources, terminate, &sum, &delta);
+        plain = 0;
+        if (rowSums != NULL && state.rowSums == NULL)
+        { // the next sweeps compare their sums to this one
+            sum = sumGrid(grid, rowSums);
+        }
+    }
+    if (plain && sweep == calculateOneRedBlack && processes != 1)
     {
-        *bottom = grid[x + 1][y];
+        finished = calculateProcesses(&state, sources, num_sources, terminate, n_iter, processes, &delta, &done) == 0;
     }
-    if (y == m - 1)
+    if (!finished && plain && sweep == calculateOneRedBlack && threads > 1)
     {
-        *right = 0;
+        finished = calculateParallel(&state, workspace != NULL ? &workspace->pool : NULL, terminate, n_iter, threads,
+                                     &delta, &done) == 0;
     }
-    else
+    if (!finished && plain && order == ORDER_ROW && n_iter > 1 && !is_cyclic && rowSums == NULL &&
+        state.blockSweeps > 1)
     {
-        *right = grid[x][y + 1];
+        chooseBlockCols(&state.blockCols, state.blockSweeps, grid->m, stencil->diagonals);
+        if (calculateTemporal(&state, n_iter, &delta) == 0)
+        {
+            finished = 1;
+            done = n_iter;
+        }
     }
 
+    while (!finished && !stopped && (n_iter > 0 ? done < n_iter : done == 0 || delta > terminate || -delta > terminate))
+    {
+        if (profileLevel)
+        {
+            profileMark(&mark);
+        }
+        previousSum = sum;
+        sum = sweep(&state);
+        if (rowSums != NULL && state.rowSums == NULL)
+        { // the sweep added up the points in its own order
+            sum = sumGrid(grid, rowSums);
+        }
+        delta = sum - previousSum;
+        ++done;
+        if (profileLevel)
+        {
+            profileSweep(&mark, delta);
+        }
+        if (options->progress != NULL)
+        {
+            told = 1;
+            stopped = options->progress(options->progressData, done - options->resumeSweeps, delta) != 0;
+        }
+        if (options->checkpoint != NULL && options->checkpointEvery > 0 && done % options->checkpointEvery == 0)
+        {
+            GridFileInfo info = {terminate, n_iter, is_cyclic, done, sum, delta};
+            if (writeGridFile(options->checkpoint, grid, sources, num_sources, &info))
+            {
+                fprintf(stderr, ERROR_CHECKPOINT);
+            }
+        }
+    }
+    if (options->progress != NULL && !told)
+    { // the sweeps were not done one by one
+        stopped = options->progress(options->progressData, done - options->resumeSweeps, delta) != 0;
+    }
+    if (workspace == NULL)
+    {
+        freeSourceIndex(&state.index);
+    }
+    releaseCursor(workspace, state.cursor);
+    free(rowSums);
+    if (skipTiles)
+    {
+        freeActiveTiles(&active);
+    }
+    if (options->sweeps != NULL)
+    {
+        *options->sweeps += done - options->resumeSweeps;
+    }
+    if (profileLevel)
+    {
+        profileSweeps(done - options->resumeSweeps, delta);
+        profilePhase(PHASE_CALCULATE, &call);
+    }
+    *result = delta;
+    return stopped ? HEAT_ERROR_STOPPED : HEAT_OK;
 }
 
 /**
- * calculate for each points on the grid the new heat
- * @param function heat function
+ * Same as calculate() but on a contiguous grid.
+ * @param function function that calculate the temperature of a coordinate
  * @param grid the grid
- * @param n width
- * @param m length
- * @param sources list of sources
+ * @param sources list of the sources points
  * @param num_sources number of sources
- * @param is_cyclic
- * @return the sum of the points on the grid
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param options how to sweep, NULL for the default options
+ * @return the difference between the sums of the two last sweeps
  */
-double calculateOne(diff_func function, double **grid, int n, int m, source_point *sources, size_t num_sources,
-                    int is_cyclic)
+double calculateGrid(diff_func function, Grid *grid, source_point *sources, size_t num_sources, double terminate,
+                     unsigned int n_iter, int is_cyclic, const SolverOptions *options)
 {
-    double sum = 0;
-    int flagCalculate = 1;
-    double right, top, left, bottom;
-    for (int y = 0; y < m; ++y)
+    double delta = 0;
+    int status = tryCalculateGrid(function, grid, sources, num_sources, terminate, n_iter, is_cyclic, options, &delta);
+    if (status != HEAT_OK && status != HEAT_ERROR_STOPPED)
     {
-        for (int x = 0; x < n; ++x)
-        {
-            for (int i = 0; i < (int) num_sources; ++i)
-            { // check if the point is a source
-                if (sources[i].x == x && sources[i].y == y)
-                {
-                    flagCalculate = 0;
-                    break;
-                }
-            }
-            if (flagCalculate)
-            {// calculate if the point is not a source
-                if (!is_cyclic)
-                {
-                    notCyclic(grid, &right, &top, &left, &bottom, x, y, n, m);
-
-                }
-                else
-                { // if it's cyclic
-                    cyclic(grid, &right, &top, &left, &bottom, x, y, n, m);
-
-                }
-                grid[x][y] = function(grid[x][y], right, top, left, bottom);
-            }
-            sum += grid[x][y];
-            flagCalculate = 1;
-        }
+        fprintf(stderr, "%s", statusMessage(status));
+        exit(1);
     }
-    return sum;
+    return delta;
 }
 
 /**
  * Calculator function. Applies the given function to every point in the grid iteratively for n_iter loops, or until the
  * cumulative difference is below terminate (if n_iter is 0).
+ * The rows are copied to a contiguous grid and back, so they can be allocated in any way (one block or not).
  * @param function function that calculate the temperature of a coordinate
  * @param grid pointer of pointer of value (double) of temperature
  * @param n width of the grid
@@ -174,30 +374,23 @@ double calculateOne(diff_func function, double **grid, int n, int m, source_poin
 double calculate(diff_func function, double **grid, size_t n, size_t m, source_point *sources, size_t num_sources,
                  double terminate, unsigned int n_iter, int is_cyclic)
 {
-    double sum = 0, previousSum = 0;
-    sum = calculateOne(function, grid, (int) n, (int) m, sources, num_sources, is_cyclic);
-    double delta = sum - previousSum;
+    Grid copy;
+    double delta;
 
-    if (n_iter > 0)
-    { // if it's cyclic
-        for (int i = 0; i < (int) n_iter - 1; ++i)
-        {
-            previousSum = sum;
-            sum = calculateOne(function, grid, (int) n, (int) m, sources, num_sources, is_cyclic);
-            delta = sum - previousSum;
-        }
+    if (initGrid(&copy, n, m))
+    {
+        fprintf(stderr, "%s", statusMessage(HEAT_ERROR_MEMORY));
+        exit(1);
     }
-    else
+    for (size_t i = 0; i < n; ++i)
     {
-        while (delta > terminate || -delta > terminate)
-        {
-            previousSum = sum;
-            sum = calculateOne(function, grid, (int) n, (int) m, sources, num_sources, is_cyclic);
-            delta = sum - previousSum;
-        }
+        memcpy(GRID_ROW(&copy, i), grid[i], sizeof(double) * m);
     }
-
-
+    delta = calculateGrid(function, &copy, sources, num_sources, terminate, n_iter, is_cyclic, NULL);
+    for (size_t i = 0; i < n; ++i)
+    {
+        memcpy(grid[i], GRID_ROW(&copy, i), sizeof(double) * m);
+    }
+    freeGrid(&copy);
     return delta;
 }
-
@@ -0,0 +1,93 @@
+/**
+ * @file generate.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief heatgen: write a synthetic input file for the benchmarks
+ */
+
+// ------------------------------ includes --------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// -------------------------- const definitions -------------------------
+#define USAGE "Usage: heatgen <n> <m> <source density> <is_cyclic> [terminate] [n_iter] [seed]\n"
+#define ERROR_ARGUMENT "Error with argument: %s.\n"
+#define SEPARATOR "----\n"
+#define DEFAULT_TERMINATE "1e-3"
+#define DEFAULT_N_ITER "0"
+#define DEFAULT_SEED "1"
+#define MAX_SOURCE_VALUE 100.0
+
+// ------------------------------ functions -------------------------------
+/**
+ * next number of a xorshift64* generator, the same on every machine so a seed always gives the same file
+ * @param state the state of the generator, not 0
+ * @return the number
+ */
+static uint64_t nextRandom(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+/**
+ * read a number argument
+ * @param value the argument
+ * @param result set to the number
+ * @return 0 if it's work and 1 if not
+ */
+static int parseNumber(const char *value, double *result)
+{
+    char *end;
+    *result = strtod(value, &end);
+    return end == value || *end != '\0';
+}
+
+/**
+ * The main function: write a n*m input with about density * n * m sources at random places, with values between
+ * -MAX_SOURCE_VALUE and MAX_SOURCE_VALUE, to the standard output
+ * @param argc
+ * @param argv n, m, source density (0 to 1), is_cyclic and optionally terminate, n_iter and the seed
+ * @return 0 if it's work and 1 if not
+ */
+int main(int argc, char *argv[])
+{
+    double n, m, density, cyclic, n_iter, seed, terminate;
+    if (argc < 5 || argc > 8)
+    {
+        fprintf(stderr, USAGE);
+        return 1;
+    }
+    const char *arguments[] = {argv[1], argv[2], argv[3], argv[4], argc > 5 ? argv[5] : DEFAULT_TERMINATE,
+                               argc > 6 ? argv[6] : DEFAULT_N_ITER, argc > 7 ? argv[7] : DEFAULT_SEED};
+    double *values[] = {&n, &m, &density, &cyclic, &terminate, &n_iter, &seed};
+    for (int i = 0; i < 7; ++i)
+    {
+        if (parseNumber(arguments[i], values[i]))
+        {
+            fprintf(stderr, ERROR_ARGUMENT, arguments[i]);
+            return 1;
+        }
+    }
+    if (n < 1 || m < 1 || density < 0 || density > 1 || n_iter < 0)
+    {
+        fprintf(stderr, USAGE);
+        return 1;
+    }
+    uint64_t state = (uint64_t) seed * 2 + 1;
+    unsigned long count = (unsigned long) (density * n * m);
+    printf("%lu, %lu\n" SEPARATOR, (unsigned long) n, (unsigned long) m);
+    for (unsigned long i = 0; i < count; ++i)
+    {
+        unsigned long x = (unsigned long) (nextRandom(&state) % (uint64_t) n);
+        unsigned long y = (unsigned long) (nextRandom(&state) % (uint64_t) m);
+        double value = ((double) (nextRandom(&state) >> 11) / (double) (1ULL << 53) * 2 - 1) * MAX_SOURCE_VALUE;
+        printf("%lu, %lu, %.3f\n", x, y, value);
+    }
+    printf(SEPARATOR "%s\n%lu\n%d\n", arguments[4], (unsigned long) n_iter, cyclic != 0);
+    return 0;
+}
@@ -0,0 +1,380 @@
+/**
+ * @file grid.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief contiguous storage of the temperature grid
+ */
+#define _GNU_SOURCE
+
+// ------------------------------ includes --------------------------------
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "grid.h"
+
+// -------------------------- const definitions -------------------------
+#define DOUBLES_PER_LINE (GRID_ALIGNMENT / sizeof(double))
+#define FLOATS_PER_LINE (GRID_ALIGNMENT / sizeof(float))
+#define MAP_TEMPLATE "%s/heat-grid-XXXXXX"
+
+// ------------------------------ functions -------------------------------
+/**
+ * allocate a n*m grid with 0 on each coordinate, and on the ghost layer
+ * the first point of each row is aligned on a cache line, the left ghost point is the last one of the line before it
+ * @param grid the grid
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not
+ */
+int initGrid(Grid *grid, size_t n, size_t m)
+{
+    void *block = NULL;
+    size_t stride = (DOUBLES_PER_LINE + m + 1 + DOUBLES_PER_LINE - 1) / DOUBLES_PER_LINE * DOUBLES_PER_LINE;
+    size_t cells = (n + 2) * stride;
+
+    grid->data = NULL;
+    grid->block = NULL;
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    grid->halo = 1;
+    grid->capacity = 0;
+    grid->mapped = 0;
+    grid->fd = -1;
+    if (stride <= m || cells / stride != n + 2)
+    {
+        return 1;
+    }
+    if (cells >= SIZE_MAX / sizeof(double))
+    {
+        return 1;
+    }
+    if (posix_memalign(&block, GRID_ALIGNMENT, cells * sizeof(double)) != 0)
+    {
+        return 1;
+    }
+    memset(block, 0, cells * sizeof(double));
+    grid->block = (double *) block;
+    grid->data = grid->block + stride + DOUBLES_PER_LINE;
+    grid->capacity = cells;
+    return 0;
+}
+
+/**
+ * make a n*m grid like initGrid, with its block mapped from a new file of a directory instead of allocated
+ * The file is made as large as the block, so it reads as 0 without being written, and the mapping is read in order.
+ * @param grid the grid
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param directory the directory of the file
+ * @return 0 if it's work and 1 if not
+ */
+int mapGrid(Grid *grid, size_t n, size_t m, const char *directory)
+{
+    size_t stride = (DOUBLES_PER_LINE + m + 1 + DOUBLES_PER_LINE - 1) / DOUBLES_PER_LINE * DOUBLES_PER_LINE;
+    size_t cells = (n + 2) * stride, length = strlen(directory) + sizeof(MAP_TEMPLATE);
+
+    grid->data = NULL;
+    grid->block = NULL;
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    grid->halo = 1;
+    grid->capacity = 0;
+    grid->mapped = 0;
+    grid->fd = -1;
+    if (stride <= m || cells / stride != n + 2 || cells >= SIZE_MAX / sizeof(double))
+    {
+        return 1;
+    }
+    char *path = (char *) malloc(length);
+    if (path == NULL)
+    {
+        return 1;
+    }
+    snprintf(path, length, MAP_TEMPLATE, directory);
+    int fd = mkstemp(path);
+    if (fd >= 0)
+    {
+        unlink(path);
+    }
+    free(path);
+    void *block = MAP_FAILED;
+    if (fd >= 0 && ftruncate(fd, (off_t) (cells * sizeof(double))) == 0)
+    {
+        block = mmap(NULL, cells * sizeof(double), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (block == MAP_FAILED)
+    {
+        if (block != MAP_FAILED)
+        {
+            munmap(block, cells * sizeof(double));
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return 1;
+    }
+    madvise(block, cells * sizeof(double), MADV_SEQUENTIAL);
+    grid->block = (double *) block;
+    grid->data = grid->block + stride + DOUBLES_PER_LINE;
+    grid->capacity = cells;
+    grid->mapped = cells * sizeof(double);
+    grid->fd = fd;
+    return 0;
+}
+
+/**
+ * tell the kernel what happens next to the rows from..to-1 of a mapped grid
+ * The range is widened to whole pages to prefetch, and narrowed to them to release, so the rows around it stay.
+ * @param grid the grid
+ * @param from first row
+ * @param to after the last row, at most n
+ * @param advice GRID_PREFETCH or GRID_RELEASE
+ */
+void adviseGridRows(const Grid *grid, size_t from, size_t to, int advice)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    if (grid->mapped == 0 || from >= to || page <= 0)
+    {
+        return;
+    }
+    size_t first = (size_t) ((char *) GRID_ROW(grid, from) - (char *) grid->block);
+    size_t last = (size_t) ((char *) GRID_ROW(grid, to) - (char *) grid->block), size = (size_t) page;
+    if (advice == GRID_PREFETCH)
+    {
+        first = first / size * size;
+        last = (last + size - 1) / size * size;
+        last = last < grid->mapped ? last : grid->mapped;
+        madvise((char *) grid->block + first, last - first, MADV_WILLNEED);
+        return;
+    }
+    first = (first + size - 1) / size * size;
+    last = last / size * size;
+    if (first < last)
+    { // the dirty pages stay in the page cache, they are written back from there
+        madvise((char *) grid->block + first, last - first, MADV_DONTNEED);
+        sync_file_range(grid->fd, (off_t) first, (off_t) (last - first), SYNC_FILE_RANGE_WRITE);
+    }
+}
+
+/**
+ * free the grid
+ * @param grid the grid
+ */
+void freeGrid(Grid *grid)
+{
+    if (grid->block != NULL && grid->mapped > 0)
+    {
+        munmap(grid->block, grid->mapped);
+        close(grid->fd);
+    }
+    else
+    {
+        free(grid->block);
+    }
+    grid->block = NULL;
+    grid->data = NULL;
+    grid->mapped = 0;
+    grid->fd = -1;
+}
+
+/**
+ * make the grid a n*m grid with 0 on each coordinate and on the ghost layer, in its memory if it is large enough and
+ * in a new one otherwise
+ * @param grid a grid from initGrid or resizeGrid, or with block NULL
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not, the grid is then freed
+ */
+int resizeGrid(Grid *grid, size_t n, size_t m)
+{
+    size_t stride = (DOUBLES_PER_LINE + m + 1 + DOUBLES_PER_LINE - 1) / DOUBLES_PER_LINE * DOUBLES_PER_LINE;
+    size_t cells = (n + 2) * stride;
+
+    if (grid->block == NULL || grid->mapped > 0 || stride <= m || cells / stride != n + 2 || cells > grid->capacity)
+    {
+        freeGrid(grid);
+        return initGrid(grid, n, m);
+    }
+    memset(grid->block, 0, cells * sizeof(double));
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    grid->data = grid->block + stride + DOUBLES_PER_LINE;
+    return 0;
+}
+
+/**
+ * fill the ghost layer for the next sweep: 0 if the grid is not cyclic, otherwise a copy of the opposite edge
+ * the corners are filled too (with the opposite corner when cyclic), for the stencils reading the diagonals
+ * @param grid the grid, with a ghost layer
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+void fillHalo(Grid *grid, int is_cyclic)
+{
+    fillHaloEdges(grid, is_cyclic);
+    fillHaloRows(grid, 0, (ptrdiff_t) grid->n, is_cyclic);
+}
+
+/**
+ * fill the ghost rows -1 and n for the next sweep, with their ghost points
+ * @param grid the grid, with a ghost layer
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+void fillHaloEdges(Grid *grid, int is_cyclic)
+{
+    ptrdiff_t n = (ptrdiff_t) grid->n, m = (ptrdiff_t) grid->m;
+    double *top = GRID_ROW(grid, -1), *bottom = GRID_ROW(grid, n);
+
+    if (n == 0 || m == 0)
+    {
+        return;
+    }
+    if (!is_cyclic)
+    {
+        memset(top, 0, sizeof(double) * (size_t) m);
+        memset(bottom, 0, sizeof(double) * (size_t) m);
+    }
+    else
+    {
+        memcpy(top, GRID_ROW(grid, n - 1), sizeof(double) * (size_t) m);
+        memcpy(bottom, GRID_ROW(grid, 0), sizeof(double) * (size_t) m);
+    }
+    // rows -1 and n are already copies, so their ends get the opposite corners
+    fillHaloRows(grid, -1, 0, is_cyclic);
+    fillHaloRows(grid, n, n + 1, is_cyclic);
+}
+
+/**
+ * fill the ghost points of the rows from..to-1 for the next sweep: 0 if the grid is not cyclic, otherwise a copy of
+ * the other end of the row
+ * @param grid the grid, with a ghost layer
+ * @param from first row
+ * @param to after the last row
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+void fillHaloRows(Grid *grid, ptrdiff_t from, ptrdiff_t to, int is_cyclic)
+{
+    ptrdiff_t m = (ptrdiff_t) grid->m;
+
+    if (grid->n == 0 || m == 0)
+    {
+        return;
+    }
+    for (ptrdiff_t x = from; x < to; ++x)
+    {
+        GRID_AT(grid, x, -1) = is_cyclic ? GRID_AT(grid, x, m - 1) : 0;
+        GRID_AT(grid, x, m) = is_cyclic ? GRID_AT(grid, x, 0) : 0;
+    }
+}
+
+/**
+ * allocate a n*m float grid with 0 on each coordinate, and on the ghost layer, laid out like initGrid does
+ * @param grid the grid
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not
+ */
+int initFloatGrid(FloatGrid *grid, size_t n, size_t m)
+{
+    void *block = NULL;
+    size_t stride = (FLOATS_PER_LINE + m + 1 + FLOATS_PER_LINE - 1) / FLOATS_PER_LINE * FLOATS_PER_LINE;
+    size_t cells = (n + 2) * stride;
+
+    grid->data = NULL;
+    grid->block = NULL;
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    grid->capacity = 0;
+    if (stride <= m || cells / stride != n + 2 || cells >= SIZE_MAX / sizeof(float))
+    {
+        return 1;
+    }
+    if (posix_memalign(&block, GRID_ALIGNMENT, cells * sizeof(float)) != 0)
+    {
+        return 1;
+    }
+    memset(block, 0, cells * sizeof(float));
+    grid->block = (float *) block;
+    grid->data = grid->block + stride + FLOATS_PER_LINE;
+    grid->capacity = cells;
+    return 0;
+}
+
+/**
+ * free the float grid
+ * @param grid the grid
+ */
+void freeFloatGrid(FloatGrid *grid)
+{
+    free(grid->block);
+    grid->block = NULL;
+    grid->data = NULL;
+}
+
+/**
+ * make the float grid a n*m grid with 0 on each coordinate, like resizeGrid
+ * @param grid a grid from initFloatGrid or resizeFloatGrid, or with block NULL
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not, the grid is then freed
+ */
+int resizeFloatGrid(FloatGrid *grid, size_t n, size_t m)
+{
+    size_t stride = (FLOATS_PER_LINE + m + 1 + FLOATS_PER_LINE - 1) / FLOATS_PER_LINE * FLOATS_PER_LINE;
+    size_t cells = (n + 2) * stride;
+
+    if (grid->block == NULL || stride <= m || cells / stride != n + 2 || cells > grid->capacity)
+    {
+        freeFloatGrid(grid);
+        return initFloatGrid(grid, n, m);
+    }
+    memset(grid->block, 0, cells * sizeof(float));
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    grid->data = grid->block + stride + FLOATS_PER_LINE;
+    return 0;
+}
+
+/**
+ * fill the ghost layer of a float grid, like fillHalo
+ * @param grid the grid
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+void fillFloatHalo(FloatGrid *grid, int is_cyclic)
+{
+    ptrdiff_t n = (ptrdiff_t) grid->n, m = (ptrdiff_t) grid->m;
+    float *top = GRID_ROW(grid, -1), *bottom = GRID_ROW(grid, n);
+
+    if (n == 0 || m == 0)
+    {
+        return;
+    }
+    if (!is_cyclic)
+    {
+        memset(top, 0, sizeof(float) * (size_t) m);
+        memset(bottom, 0, sizeof(float) * (size_t) m);
+        for (ptrdiff_t x = -1; x <= n; ++x)
+        {
+            GRID_AT(grid, x, -1) = 0;
+            GRID_AT(grid, x, m) = 0;
+        }
+        return;
+    }
+    memcpy(top, GRID_ROW(grid, n - 1), sizeof(float) * (size_t) m);
+    memcpy(bottom, GRID_ROW(grid, 0), sizeof(float) * (size_t) m);
+    for (ptrdiff_t x = -1; x <= n; ++x)
+    {
+        GRID_AT(grid, x, -1) = GRID_AT(grid, x, m - 1);
+        GRID_AT(grid, x, m) = GRID_AT(grid, x, 0);
+    }
+}
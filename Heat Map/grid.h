@@ -0,0 +1,161 @@
+/**
+ * @file grid.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief contiguous storage of the temperature grid
+ */
+#ifndef GRID_H
+#define GRID_H
+
+// ------------------------------ includes --------------------------------
+#include <stddef.h>
+
+// -------------------------- const definitions -------------------------
+#define GRID_ALIGNMENT 64
+
+#define GRID_PREFETCH 0
+#define GRID_RELEASE 1
+
+/**
+ * A n*m grid of temperatures stored as one aligned row-major block.
+ * Row x starts at data + x * stride.
+ * Grids from initGrid have a ghost layer (halo == 1): rows -1 and n and columns -1 and m exist around the points,
+ * so a sweep can read the four neighbours of any point without checking the boundary.
+ * capacity is the number of points of block, resizeGrid reuses it for a grid which fits. mapped is the size in bytes
+ * of block when it is a mapping of the file fd (see mapGrid), 0 when it is allocated (fd is then -1).
+ */
+typedef struct Grid
+{
+    double *data;
+    double *block;
+    size_t n;
+    size_t m;
+    size_t stride;
+    int halo;
+    size_t capacity;
+    size_t mapped;
+    int fd;
+} Grid;
+
+#define GRID_ROW(grid, x) ((grid)->data + (ptrdiff_t) (x) * (ptrdiff_t) (grid)->stride)
+#define GRID_AT(grid, x, y) (GRID_ROW(grid, x)[y])
+
+/**
+ * The same grid with the temperatures stored as float, for the single and mixed precisions: half the memory of a
+ * Grid and twice the points in a SIMD register. It always has a ghost layer, GRID_ROW and GRID_AT work on it too.
+ * capacity is the number of points of block.
+ */
+typedef struct FloatGrid
+{
+    float *data;
+    float *block;
+    size_t n;
+    size_t m;
+    size_t stride;
+    size_t capacity;
+} FloatGrid;
+
+// ------------------------------ functions -------------------------------
+/**
+ * allocate a n*m grid with 0 on each coordinate, and on the ghost layer
+ * @param grid the grid
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not
+ */
+int initGrid(Grid *grid, size_t n, size_t m);
+
+/**
+ * make a n*m grid like initGrid, with its block mapped from a new file of a directory instead of allocated, for the
+ * grids larger than the memory. The file is removed right away, its space is given back when the grid is freed.
+ * @param grid the grid
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param directory the directory of the file
+ * @return 0 if it's work and 1 if not
+ */
+int mapGrid(Grid *grid, size_t n, size_t m, const char *directory);
+
+/**
+ * tell the kernel what happens next to the rows from..to-1 of a mapped grid (nothing for the other grids):
+ * GRID_PREFETCH starts reading them, GRID_RELEASE drops them from the mapping and starts writing them back, so their
+ * pages can be reused without waiting
+ * @param grid the grid
+ * @param from first row
+ * @param to after the last row, at most n
+ * @param advice GRID_PREFETCH or GRID_RELEASE
+ */
+void adviseGridRows(const Grid *grid, size_t from, size_t to, int advice);
+
+/**
+ * free the grid
+ * @param grid the grid
+ */
+void freeGrid(Grid *grid);
+
+/**
+ * make the grid a n*m grid with 0 on each coordinate and on the ghost layer, in its memory if it is large enough and
+ * in a new one otherwise
+ * @param grid a grid from initGrid or resizeGrid, or with block NULL
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not, the grid is then freed
+ */
+int resizeGrid(Grid *grid, size_t n, size_t m);
+
+/**
+ * fill the ghost layer for the next sweep: 0 if the grid is not cyclic, otherwise a copy of the opposite edge
+ * @param grid the grid, with a ghost layer
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+void fillHalo(Grid *grid, int is_cyclic);
+
+/**
+ * fill the ghost rows -1 and n for the next sweep, like fillHalo: with fillHaloRows on all the rows it is fillHalo
+ * @param grid the grid, with a ghost layer
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+void fillHaloEdges(Grid *grid, int is_cyclic);
+
+/**
+ * fill the ghost points of the rows from..to-1 for the next sweep, like fillHalo, before any of them is calculated
+ * @param grid the grid, with a ghost layer
+ * @param from first row
+ * @param to after the last row
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+void fillHaloRows(Grid *grid, ptrdiff_t from, ptrdiff_t to, int is_cyclic);
+
+/**
+ * allocate a n*m float grid with 0 on each coordinate, and on the ghost layer
+ * @param grid the grid
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not
+ */
+int initFloatGrid(FloatGrid *grid, size_t n, size_t m);
+
+/**
+ * free the float grid
+ * @param grid the grid
+ */
+void freeFloatGrid(FloatGrid *grid);
+
+/**
+ * make the float grid a n*m grid with 0 on each coordinate, like resizeGrid
+ * @param grid a grid from initFloatGrid or resizeFloatGrid, or with block NULL
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not, the grid is then freed
+ */
+int resizeFloatGrid(FloatGrid *grid, size_t n, size_t m);
+
+/**
+ * fill the ghost layer of a float grid, like fillHalo
+ * @param grid the grid
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+void fillFloatHalo(FloatGrid *grid, int is_cyclic);
+
+#endif //GRID_H
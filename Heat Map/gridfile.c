@@ -0,0 +1,217 @@
+/**
+ * @file gridfile.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief binary grid files: the input of a run and its checkpoints
+ */
+#define _DEFAULT_SOURCE
+
+// ------------------------------ includes --------------------------------
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "gridfile.h"
+#include "output.h"
+
+// -------------------------- const definitions -------------------------
+#define TEMP_SUFFIX ".tmp"
+
+// ------------------------------ functions -------------------------------
+/**
+ * tell if a file is a binary grid file
+ * only regular files are, so nothing is read from a pipe
+ * @param path the file
+ * @return 1 if it starts like one and 0 if not
+ */
+int isGridFile(const char *path)
+{
+    char magic[GRID_FILE_MAGIC_SIZE];
+    struct stat status;
+    if (stat(path, &status) != 0 || !S_ISREG(status.st_mode))
+    { // a pipe can't be read twice, and can't be mapped anyway
+        return 0;
+    }
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        return 0;
+    }
+    int found = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+                memcmp(magic, GRID_FILE_MAGIC, GRID_FILE_MAGIC_SIZE) == 0;
+    fclose(fp);
+    return found;
+}
+
+/**
+ * check the header against the size of the file
+ * @param header the header
+ * @param size size of the file
+ * @return 0 if the file has the size the header tells and 1 if not
+ */
+static int checkHeader(const GridFileHeader *header, size_t size)
+{
+    uint64_t n = header->n, m = header->m, count = header->numSources;
+    if (memcmp(header->magic, GRID_FILE_MAGIC, GRID_FILE_MAGIC_SIZE) != 0 || header->version != GRID_FILE_VERSION)
+    {
+        return 1;
+    }
+    if (n > INT32_MAX || m > INT32_MAX || header->n_iter > UINT32_MAX || count > size / sizeof(GridFileSource))
+    {
+        return 1;
+    }
+    if (m != 0 && n > (size - sizeof(GridFileHeader)) / sizeof(double) / m)
+    {
+        return 1;
+    }
+    return sizeof(GridFileHeader) + count * sizeof(GridFileSource) + n * m * sizeof(double) != size;
+}
+
+/**
+ * load a binary grid file, mapped in memory
+ * the points are copied from the mapping to a grid with a ghost layer, without any parsing
+ * @param path the file
+ * @param grid set to the grid, with its sources
+ * @param sources set to the list of the sources, to free
+ * @param num_sources set to the number of sources
+ * @param info set to the rest of the header
+ * @return 0 if it's work and 1 if not
+ */
+int loadGridFile(const char *path, Grid *grid, source_point **sources, size_t *num_sources, GridFileInfo *info)
+{
+    struct stat status;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return 1;
+    }
+    if (fstat(fd, &status) != 0 || (size_t) status.st_size < sizeof(GridFileHeader))
+    {
+        close(fd);
+        return 1;
+    }
+    size_t size = (size_t) status.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        return 1;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    const GridFileHeader *header = (const GridFileHeader *) map;
+    if (checkHeader(header, size))
+    {
+        munmap(map, size);
+        return 1;
+    }
+    const GridFileSource *fileSources = (const GridFileSource *) (header + 1);
+    const double *points = (const double *) (fileSources + header->numSources);
+    size_t n = (size_t) header->n, m = (size_t) header->m, count = (size_t) header->numSources;
+
+    *sources = (source_point *) malloc(sizeof(source_point) * (count + 1));
+    if (*sources == NULL || initGrid(grid, n, m))
+    {
+        free(*sources);
+        munmap(map, size);
+        return 1;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (fileSources[i].x < 0 || fileSources[i].y < 0 || (size_t) fileSources[i].x >= n ||
+            (size_t) fileSources[i].y >= m)
+        {
+            free(*sources);
+            freeGrid(grid);
+            munmap(map, size);
+            return 1;
+        }
+        (*sources)[i].x = fileSources[i].x;
+        (*sources)[i].y = fileSources[i].y;
+        (*sources)[i].value = fileSources[i].value;
+    }
+    for (size_t x = 0; x < n; ++x)
+    {
+        memcpy(GRID_ROW(grid, x), points + x * m, sizeof(double) * m);
+    }
+    *num_sources = count;
+    info->terminate = header->terminate;
+    info->n_iter = (unsigned int) header->n_iter;
+    info->is_cyclic = header->is_cyclic;
+    info->sweeps = (unsigned long) header->sweeps;
+    info->sum = header->sum;
+    info->delta = header->delta;
+    munmap(map, size);
+    return 0;
+}
+
+/**
+ * write a binary grid file, to a temporary file renamed over path once complete, so a run killed while it writes
+ * keeps the checkpoint before
+ * @param path the file
+ * @param grid the grid
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param info the rest of the header
+ * @return 0 if it's work and 1 if not
+ */
+int writeGridFile(const char *path, const Grid *grid, const source_point *sources, size_t num_sources,
+                  const GridFileInfo *info)
+{
+    GridFileHeader header;
+    Output out;
+    size_t length = strlen(path);
+    char *temp = (char *) malloc(length + sizeof(TEMP_SUFFIX));
+    if (temp == NULL)
+    {
+        return 1;
+    }
+    memcpy(temp, path, length);
+    memcpy(temp + length, TEMP_SUFFIX, sizeof(TEMP_SUFFIX));
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || openOutput(&out, fd, OUTPUT_BUFFER_SIZE))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        free(temp);
+        return 1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GRID_FILE_MAGIC, GRID_FILE_MAGIC_SIZE);
+    header.version = GRID_FILE_VERSION;
+    header.is_cyclic = info->is_cyclic;
+    header.n = grid->n;
+    header.m = grid->m;
+    header.numSources = num_sources;
+    header.n_iter = info->n_iter;
+    header.sweeps = info->sweeps;
+    header.terminate = info->terminate;
+    header.sum = info->sum;
+    header.delta = info->delta;
+    outputBytes(&out, &header, sizeof(header));
+    for (size_t i = 0; i < num_sources; ++i)
+    {
+        GridFileSource source = {sources[i].x, sources[i].y, sources[i].value};
+        outputBytes(&out, &source, sizeof(source));
+    }
+    for (size_t x = 0; x < grid->n; ++x)
+    {
+        outputBytes(&out, GRID_ROW(grid, x), sizeof(double) * grid->m);
+    }
+    int failed = closeOutput(&out);
+    failed = fsync(fd) != 0 || failed;
+    failed = close(fd) != 0 || failed;
+    failed = failed || rename(temp, path) != 0;
+    if (failed)
+    {
+        unlink(temp);
+    }
+    free(temp);
+    return failed;
+}
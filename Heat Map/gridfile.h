@@ -0,0 +1,97 @@
+/**
+ * @file gridfile.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief binary grid files: the input of a run and its checkpoints
+ */
+#ifndef GRIDFILE_H
+#define GRIDFILE_H
+
+// ------------------------------ includes --------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include "calculator.h"
+#include "grid.h"
+
+// -------------------------- const definitions -------------------------
+#define GRID_FILE_MAGIC "HEATGRID"
+#define GRID_FILE_MAGIC_SIZE 8
+#define GRID_FILE_VERSION 1
+
+/**
+ * The header of a binary grid file, in the byte order of the machine. It is followed by numSources GridFileSource
+ * and by the n*m points of the grid, row after row. sweeps is the number of sweeps the call of calculateGrid which
+ * wrote the file had done, sum the sum of the points after the last one and delta the difference with the sweep before.
+ * A file with sweeps == 0 is a new run.
+ */
+typedef struct GridFileHeader
+{
+    char magic[GRID_FILE_MAGIC_SIZE];
+    uint32_t version;
+    int32_t is_cyclic;
+    uint64_t n;
+    uint64_t m;
+    uint64_t numSources;
+    uint64_t n_iter;
+    uint64_t sweeps;
+    double terminate;
+    double sum;
+    double delta;
+} GridFileHeader;
+
+/**
+ * a source in a binary grid file
+ */
+typedef struct GridFileSource
+{
+    int32_t x;
+    int32_t y;
+    double value;
+} GridFileSource;
+
+/**
+ * what a grid file holds besides the grid and the sources
+ */
+typedef struct GridFileInfo
+{
+    double terminate;
+    unsigned int n_iter;
+    int is_cyclic;
+    unsigned long sweeps;
+    double sum;
+    double delta;
+} GridFileInfo;
+
+// ------------------------------ functions -------------------------------
+/**
+ * tell if a file is a binary grid file
+ * @param path the file
+ * @return 1 if it starts like one and 0 if not
+ */
+int isGridFile(const char *path);
+
+/**
+ * load a binary grid file, mapped in memory
+ * @param path the file
+ * @param grid set to the grid, with its sources
+ * @param sources set to the list of the sources, to free
+ * @param num_sources set to the number of sources
+ * @param info set to the rest of the header
+ * @return 0 if it's work and 1 if not
+ */
+int loadGridFile(const char *path, Grid *grid, source_point **sources, size_t *num_sources, GridFileInfo *info);
+
+/**
+ * write a binary grid file, to a temporary file renamed over path once complete
+ * @param path the file
+ * @param grid the grid
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param info the rest of the header
+ * @return 0 if it's work and 1 if not
+ */
+int writeGridFile(const char *path, const Grid *grid, const source_point *sources, size_t num_sources,
+                  const GridFileInfo *info);
+
+#endif //GRIDFILE_H
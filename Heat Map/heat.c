@@ -0,0 +1,226 @@
+/**
+ * @file heat.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief the solver as a library: parse an input from a file or a buffer and solve it, without exiting on an error
+ */
+#define _POSIX_C_SOURCE 200809L
+
+// ------------------------------ includes --------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "heat.h"
+
+// ------------------------------ functions -------------------------------
+/**
+ * start a context
+ * @param heat the context
+ * @param function function that calculate the temperature of a coordinate
+ * @param options the options, copied, NULL for the default options
+ */
+void heatInit(HeatContext *heat, diff_func function, const SolverOptions *options)
+{
+    memset(heat, 0, sizeof(HeatContext));
+    if (options != NULL)
+    {
+        heat->options = *options;
+    }
+    else
+    {
+        defaultOptions(&heat->options);
+    }
+    heat->options.precision = PRECISION_DOUBLE;
+    heat->options.checkpoint = NULL;
+    heat->options.workspace = &heat->workspace;
+    heat->options.changes = NULL;
+    heat->function = function;
+}
+
+/**
+ * parse an input from a file and close it
+ * @param heat the context
+ * @param fp the file, NULL if it could not be opened
+ * @return HEAT_OK or the error
+ */
+static int parseStream(HeatContext *heat, FILE *fp)
+{
+    if (fp == NULL)
+    {
+        heat->parsed = 0;
+        return HEAT_ERROR_FILE;
+    }
+    int error = readInput(fp, &heat->input);
+    fclose(fp);
+    heat->parsed = error == HEAT_OK;
+    return error;
+}
+
+/**
+ * parse an input file, in the format of ex3
+ * @param heat the context
+ * @param path the file
+ * @return HEAT_OK or the error
+ */
+int heatParseFile(HeatContext *heat, const char *path)
+{
+    return parseStream(heat, fopen(path, "r"));
+}
+
+/**
+ * parse an input held in memory, in the format of ex3
+ * @param heat the context
+ * @param buffer the input
+ * @param size its size in bytes
+ * @return HEAT_OK or the error
+ */
+int heatParseBuffer(HeatContext *heat, const char *buffer, size_t size)
+{
+    if (size == 0)
+    { // fmemopen takes no empty buffer
+        heat->parsed = 0;
+        return HEAT_ERROR_SIZE;
+    }
+    return parseStream(heat, fmemopen((void *) buffer, size, "r"));
+}
+
+/**
+ * make room for a number of points in a list kept by the context
+ * @param list the list
+ * @param capacity number of points it has room for, updated when it grows
+ * @param count number of points
+ * @return 0 if it's work and 1 if not
+ */
+static int reservePoints(source_point **list, size_t *capacity, size_t count)
+{
+    if (count <= *capacity && *list != NULL)
+    {
+        return 0;
+    }
+    source_point *grown = (source_point *) realloc(*list, sizeof(source_point) * (count + 1));
+    if (grown == NULL)
+    {
+        return 1;
+    }
+    *list = grown;
+    *capacity = count;
+    return 0;
+}
+
+/**
+ * calculate the grid of the context until its delta is not above terminate, the changes of the options only given
+ * to the first call, and keep the sources the grid was solved with
+ * @param heat the context
+ * @param progress if not NULL, called as the sweeps go
+ * @param result if not NULL, called after each call of the calculation
+ * @param data given to progress and result
+ * @param delta set to the delta of the last call
+ * @return HEAT_OK or the error
+ */
+static int solveGrid(HeatContext *heat, ProgressFunction progress, ResultFunction result, void *data, double *delta)
+{
+    HeatInput *input = &heat->input;
+    double terminate = input->terminate, last = 0;
+    int error;
+    if (reservePoints(&heat->solvedSources, &heat->solvedCapacity, (size_t) input->numSources))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    memcpy(heat->solvedSources, input->sources, sizeof(source_point) * (size_t) input->numSources);
+    heat->numSolved = (size_t) input->numSources;
+    heat->solved = 1;
+    heat->options.progress = progress;
+    heat->options.progressData = data;
+    do
+    {
+        error = tryCalculateGrid(heat->function, &heat->grid, input->sources, (size_t) input->numSources, terminate,
+                                 input->n_iter, input->is_cyclic, &heat->options, &last);
+        heat->options.changes = NULL;
+        if (error == HEAT_OK && result != NULL && result(data, &heat->grid, last))
+        {
+            error = HEAT_ERROR_STOPPED;
+        }
+    } while (error == HEAT_OK && (last > terminate || -last > terminate));
+    if (delta != NULL)
+    {
+        *delta = last;
+    }
+    return error;
+}
+
+/**
+ * solve the parsed input like ex3 does
+ * @param heat the context
+ * @param progress if not NULL, called as the sweeps go
+ * @param result if not NULL, called after each call of the calculation
+ * @param data given to progress and result
+ * @param delta set to the delta of the last call
+ * @return HEAT_OK or the error
+ */
+int heatSolve(HeatContext *heat, ProgressFunction progress, ResultFunction result, void *data, double *delta)
+{
+    HeatInput *input = &heat->input;
+    if (!heat->parsed)
+    {
+        return HEAT_ERROR_NO_INPUT;
+    }
+    if (resizeGrid(&heat->grid, (size_t) input->n, (size_t) input->m))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    placeSources(&heat->grid, input->sources, input->numSources);
+    return solveGrid(heat, progress, result, data, delta);
+}
+
+/**
+ * solve the parsed input again from the grid of the last solve
+ * @param heat the context
+ * @param progress if not NULL, called as the sweeps go
+ * @param result if not NULL, called after each call of the calculation
+ * @param data given to progress and result
+ * @param delta set to the delta of the last call
+ * @return HEAT_OK or the error
+ */
+int heatResolve(HeatContext *heat, ProgressFunction progress, ResultFunction result, void *data, double *delta)
+{
+    HeatInput *input = &heat->input;
+    size_t count;
+    if (!heat->parsed)
+    {
+        return HEAT_ERROR_NO_INPUT;
+    }
+    if (!heat->solved || heat->grid.n != (size_t) input->n || heat->grid.m != (size_t) input->m)
+    {
+        return HEAT_ERROR_WARM_START;
+    }
+    if (reservePoints(&heat->changes, &heat->changeCapacity, heat->numSolved + (size_t) input->numSources) ||
+        findSourceChanges(&heat->grid, heat->solvedSources, heat->numSolved, input->sources,
+                          (size_t) input->numSources, heat->changes, &count))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    placeSources(&heat->grid, input->sources, input->numSources);
+    heat->options.changes = heat->changes;
+    heat->options.numChanges = count;
+    return solveGrid(heat, progress, result, data, delta);
+}
+
+/**
+ * free the memory of a context
+ * @param heat the context
+ */
+void heatFree(HeatContext *heat)
+{
+    freeInput(&heat->input);
+    freeGrid(&heat->grid);
+    freeWorkspace(&heat->workspace);
+    free(heat->solvedSources);
+    free(heat->changes);
+    heat->solvedSources = NULL;
+    heat->changes = NULL;
+    heat->solvedCapacity = 0;
+    heat->changeCapacity = 0;
+    heat->parsed = 0;
+    heat->solved = 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file heat.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief the solver as a library: parse an input from a file or a buffer and solve it, without exiting on an error
+ */
+#ifndef HEAT_H
+#define HEAT_H
+
+// ------------------------------ includes --------------------------------
+#include <stddef.h>
+#include "reader.h"
+#include "solver.h"
+#include "status.h"
+
+/**
+ * called by heatSolve after each call of the calculation, where ex3 prints the grid
+ * @param data the data given to heatSolve
+ * @param grid the grid
+ * @param delta the delta of the call
+ * @return 0 to go on and not 0 to stop, heatSolve returns HEAT_ERROR_STOPPED
+ */
+typedef int (*ResultFunction)(void *data, const Grid *grid, double delta);
+
+/**
+ * What a program embedding the solver keeps: the options, the last input, the grid and the memory of the calculation.
+ * The buffers are kept from one input to the next, so solving inputs of the same size again allocates nothing (with
+ * the default options, see SolverWorkspace). The grid and the sources of the last solve are kept for heatResolve.
+ * A context is used by one thread at a time, the fields are read only. Separate contexts share nothing: each one has
+ * its own pool of threads in its workspace, so they can solve at the same time with any number of threads.
+ *     HeatContext heat;
+ *     heatInit(&heat, heat_eqn, NULL);
+ *     if (heatParseFile(&heat, path) == HEAT_OK && heatSolve(&heat, NULL, printResult, out, &delta) == HEAT_OK) ...
+ *     heatFree(&heat);
+ */
+typedef struct HeatContext
+{
+    SolverOptions options;
+    diff_func function;
+    HeatInput input;
+    Grid grid;
+    SolverWorkspace workspace;
+    source_point *solvedSources;
+    size_t numSolved;
+    size_t solvedCapacity;
+    source_point *changes;
+    size_t changeCapacity;
+    int parsed;
+    int solved;
+} HeatContext;
+
+// ------------------------------ functions -------------------------------
+/**
+ * start a context
+ * @param heat the context
+ * @param function function that calculate the temperature of a coordinate
+ * @param options the options, copied, NULL for the default options. The grid is solved in double precision.
+ */
+void heatInit(HeatContext *heat, diff_func function, const SolverOptions *options);
+
+/**
+ * parse an input file, in the format of ex3
+ * @param heat the context
+ * @param path the file
+ * @return HEAT_OK or the error, the context has no input then
+ */
+int heatParseFile(HeatContext *heat, const char *path);
+
+/**
+ * parse an input held in memory, in the format of ex3
+ * @param heat the context
+ * @param buffer the input
+ * @param size its size in bytes
+ * @return HEAT_OK or the error, the context has no input then
+ */
+int heatParseBuffer(HeatContext *heat, const char *buffer, size_t size);
+
+/**
+ * solve the parsed input like ex3 does: the grid starts with the sources, and the calculation is called again until
+ * its delta is not above the terminate of the input
+ * @param heat the context
+ * @param progress if not NULL, called as the sweeps go (see ProgressFunction)
+ * @param result if not NULL, called after each call of the calculation
+ * @param data given to progress and result
+ * @param delta set to the delta of the last call
+ * @return HEAT_OK, HEAT_ERROR_NO_INPUT, HEAT_ERROR_MEMORY, HEAT_ERROR_HALO or HEAT_ERROR_STOPPED
+ */
+int heatSolve(HeatContext *heat, ProgressFunction progress, ResultFunction result, void *data, double *delta);
+
+/**
+ * solve the parsed input again, starting from the grid of the last heatSolve or heatResolve instead of 0: for an input
+ * of the same size whose sources were moved, added, removed or changed since. The points whose source changed are
+ * found from the sources of the last solve, and the first call sweeps only the tiles around them until the change
+ * spreads (see the changes of SolverOptions).
+ * @param heat the context
+ * @param progress if not NULL, called as the sweeps go (see ProgressFunction)
+ * @param result if not NULL, called after each call of the calculation
+ * @param data given to progress and result
+ * @param delta set to the delta of the last call
+ * @return HEAT_OK, HEAT_ERROR_NO_INPUT, HEAT_ERROR_WARM_START (nothing solved yet, or another size),
+ * HEAT_ERROR_MEMORY, HEAT_ERROR_HALO or HEAT_ERROR_STOPPED
+ */
+int heatResolve(HeatContext *heat, ProgressFunction progress, ResultFunction result, void *data, double *delta);
+
+/**
+ * free the memory of a context
+ * @param heat the context
+ */
+void heatFree(HeatContext *heat);
+
+#endif //HEAT_H
@@ -0,0 +1,223 @@
+/**
+ * @file image.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief the grids printed as binary PGM or PPM frames, block-averaged down to a small image
+ */
+
+// ------------------------------ includes --------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include "image.h"
+#include "profile.h"
+#include "solver.h"
+
+// -------------------------- const definitions -------------------------
+#define MAX_HEADER 128
+#define MAX_LEVEL 255
+#define CHANNELS 3
+#define NUM_STOPS 5
+
+// the colour map, from low to high: blue, cyan, green, yellow, red
+static const unsigned char STOPS[NUM_STOPS][CHANNELS] = {{0, 0, 255}, {0, 255, 255}, {0, 255, 0}, {255, 255, 0},
+                                                        {255, 0, 0}};
+
+// ------------------------------ functions -------------------------------
+/**
+ * set up the frames of a n*m grid
+ * @param image the frames
+ * @param format FORMAT_PGM or FORMAT_PPM
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param size the largest side of the image in pixels
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @return 0 if it's work and 1 if not
+ */
+int openImage(ImageStream *image, int format, size_t n, size_t m, size_t size, const source_point *sources,
+              size_t num_sources)
+{
+    size_t side = n > m ? n : m;
+    image->format = format;
+    image->factor = size > 0 && side > size ? (side + size - 1) / size : 1;
+    image->height = (n + image->factor - 1) / image->factor;
+    image->width = (m + image->factor - 1) / image->factor;
+    image->low = 0;
+    image->high = 0;
+    for (size_t i = 0; i < num_sources; ++i)
+    {
+        if (sources[i].value < image->low)
+        {
+            image->low = sources[i].value;
+        }
+        if (sources[i].value > image->high)
+        {
+            image->high = sources[i].value;
+        }
+    }
+    image->sums = (double *) malloc(sizeof(double) * (image->width > 0 ? image->width : 1));
+    image->pixels = (unsigned char *) malloc(CHANNELS * (image->width > 0 ? image->width : 1));
+    if (image->sums == NULL || image->pixels == NULL)
+    {
+        closeImage(image);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * print the header of a frame, the delta like printDelta
+ * @param out the output
+ * @param image the frames
+ * @param delta the delta
+ */
+static void printHeader(Output *out, const ImageStream *image, double delta)
+{
+    char header[MAX_HEADER];
+    const char *magic = image->format == FORMAT_PPM ? "P6" : "P5";
+    int length = snprintf(header, sizeof(header), "%s\n# delta %f\n%zu %zu\n%d\n", magic, delta < 0 ? -delta : delta,
+                          image->width, image->height, MAX_LEVEL);
+    outputBytes(out, header, length > 0 && (size_t) length < sizeof(header) ? (size_t) length : 0);
+}
+
+/**
+ * print a row of the image from the sums of its blocks and clear the sums
+ * @param out the output
+ * @param image the frames
+ * @param m length of the grid
+ * @param rows number of rows of the grid in the blocks
+ */
+static void printPixels(Output *out, ImageStream *image, size_t m, size_t rows)
+{
+    double range = image->high - image->low;
+    unsigned char *pixel = image->pixels;
+    for (size_t b = 0; b < image->width; ++b)
+    {
+        size_t first = b * image->factor, last = first + image->factor < m ? first + image->factor : m;
+        double level = range > 0 ? (image->sums[b] / (double) (rows * (last - first)) - image->low) / range : 0.5;
+        image->sums[b] = 0;
+        if (!(level > 0))
+        { // NaN too
+            level = 0;
+        }
+        if (level > 1)
+        {
+            level = 1;
+        }
+        if (image->format != FORMAT_PPM)
+        {
+            *pixel++ = (unsigned char) (level * MAX_LEVEL + 0.5);
+            continue;
+        }
+        double position = level * (NUM_STOPS - 1);
+        int stop = position < NUM_STOPS - 1 ? (int) position : NUM_STOPS - 2;
+        double along = position - stop;
+        for (int c = 0; c < CHANNELS; ++c)
+        {
+            *pixel++ = (unsigned char) (STOPS[stop][c] + along * (STOPS[stop + 1][c] - STOPS[stop][c]) + 0.5);
+        }
+    }
+    outputBytes(out, image->pixels, (size_t) (pixel - image->pixels));
+}
+
+/**
+ * print the grid as a frame, the delta value in a comment of its header
+ * The points are added up block by block as the rows are read, a row of the image is printed once its rows are.
+ * @param out the output
+ * @param image the frames
+ * @param grid the grid
+ * @param delta the delta
+ */
+void printImage(Output *out, ImageStream *image, const Grid *grid, double delta)
+{
+    ProfileMark mark;
+    if (profileLevel)
+    {
+        profileMark(&mark);
+    }
+    printHeader(out, image, delta);
+    for (size_t b = 0; b < image->width; ++b)
+    {
+        image->sums[b] = 0;
+    }
+    for (size_t x = 0; x < grid->n; ++x)
+    {
+        const double *row = GRID_ROW(grid, x);
+        for (size_t b = 0, y = 0; b < image->width; ++b)
+        {
+            size_t last = y + image->factor < grid->m ? y + image->factor : grid->m;
+            double sum = 0;
+            for (; y < last; ++y)
+            {
+                sum += row[y];
+            }
+            image->sums[b] += sum;
+        }
+        if ((x + 1) % image->factor == 0 || x + 1 == grid->n)
+        {
+            printPixels(out, image, grid->m, x % image->factor + 1);
+        }
+    }
+    flushOutput(out);
+    if (profileLevel)
+    {
+        profilePhase(PHASE_PRINT, &mark);
+    }
+}
+
+/**
+ * print a float grid as a frame, like printImage
+ * @param out the output
+ * @param image the frames
+ * @param grid the grid
+ * @param delta the delta
+ */
+void printFloatImage(Output *out, ImageStream *image, const FloatGrid *grid, double delta)
+{
+    ProfileMark mark;
+    if (profileLevel)
+    {
+        profileMark(&mark);
+    }
+    printHeader(out, image, delta);
+    for (size_t b = 0; b < image->width; ++b)
+    {
+        image->sums[b] = 0;
+    }
+    for (size_t x = 0; x < grid->n; ++x)
+    {
+        const float *row = GRID_ROW(grid, x);
+        for (size_t b = 0, y = 0; b < image->width; ++b)
+        {
+            size_t last = y + image->factor < grid->m ? y + image->factor : grid->m;
+            double sum = 0;
+            for (; y < last; ++y)
+            {
+                sum += row[y];
+            }
+            image->sums[b] += sum;
+        }
+        if ((x + 1) % image->factor == 0 || x + 1 == grid->n)
+        {
+            printPixels(out, image, grid->m, x % image->factor + 1);
+        }
+    }
+    flushOutput(out);
+    if (profileLevel)
+    {
+        profilePhase(PHASE_PRINT, &mark);
+    }
+}
+
+/**
+ * free the frames
+ * @param image the frames
+ */
+void closeImage(ImageStream *image)
+{
+    free(image->sums);
+    free(image->pixels);
+    image->sums = NULL;
+    image->pixels = NULL;
+}
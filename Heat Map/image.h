@@ -0,0 +1,73 @@
+/**
+ * @file image.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief the grids printed as binary PGM or PPM frames, block-averaged down to a small image
+ */
+#ifndef IMAGE_H
+#define IMAGE_H
+
+// ------------------------------ includes --------------------------------
+#include "calculator.h"
+#include "grid.h"
+#include "output.h"
+
+/**
+ * The frames of a run. Each pixel is the average of a factor * factor block of points (smaller on the last rows and
+ * columns), so the image has width * height pixels for the n * m grid. The values from low to high go through the
+ * colour map (or the grey levels), the others are clamped. sums and pixels have room for a row of the image.
+ */
+typedef struct ImageStream
+{
+    int format;
+    size_t factor;
+    size_t width;
+    size_t height;
+    double low;
+    double high;
+    double *sums;
+    unsigned char *pixels;
+} ImageStream;
+
+// ------------------------------ functions -------------------------------
+/**
+ * set up the frames of a n*m grid. low and high are the lowest and the highest of 0 and the sources: the grid starts at
+ * 0 and its points are averages of their neighbours, so they stay between them.
+ * @param image the frames
+ * @param format FORMAT_PGM or FORMAT_PPM
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param size the largest side of the image in pixels
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @return 0 if it's work and 1 if not
+ */
+int openImage(ImageStream *image, int format, size_t n, size_t m, size_t size, const source_point *sources,
+              size_t num_sources);
+
+/**
+ * print the grid as a frame, the delta value in a comment of its header
+ * @param out the output
+ * @param image the frames
+ * @param grid the grid
+ * @param delta the delta
+ */
+void printImage(Output *out, ImageStream *image, const Grid *grid, double delta);
+
+/**
+ * print a float grid as a frame, like printImage
+ * @param out the output
+ * @param image the frames
+ * @param grid the grid
+ * @param delta the delta
+ */
+void printFloatImage(Output *out, ImageStream *image, const FloatGrid *grid, double delta);
+
+/**
+ * free the frames
+ * @param image the frames
+ */
+void closeImage(ImageStream *image);
+
+#endif //IMAGE_H
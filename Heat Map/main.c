@@ -0,0 +1,283 @@
+/**
+ * @file main.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief the ex3 program: read the input, calculate the grid and print it
+ */
+#define _POSIX_C_SOURCE 200112L
+
+// ------------------------------ includes --------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "batch.h"
+#include "gridfile.h"
+#include "heat_eqn.h"
+#include "image.h"
+#include "profile.h"
+#include "reader.h"
+#include "solver.h"
+#include "writer.h"
+
+// -------------------------- const definitions -------------------------
+#define ERROR_MEMORY "Memory allocation failed."
+#define ERROR_GRID_FILE "Error with file format: binary grid."
+#define ERROR_CHECKPOINT "Error writing the checkpoint.\n"
+#define ERROR_SAVE "Error writing the saved grid.\n"
+#define ERROR_MAP "Error mapping the grid in the out-of-core directory.\n"
+#define USAGE "Usage: ex3 [--option=value ...] <input file> [<input file or directory> ...]\n"
+
+// ------------------------------ functions -------------------------------
+/**
+ * start the writer of the grids, with the frames of the grid if the format is an image
+ * @param writer the writer
+ * @param out the output
+ * @param image the frames, set up if the format is an image
+ * @param options the options
+ * @param n width
+ * @param m length
+ * @param listSources list of source
+ * @param numSource number of sources
+ * @return 0 if it's work and 1 if not
+ */
+static int startWriter(GridWriter *writer, Output *out, ImageStream *image, const SolverOptions *options, size_t n,
+                       size_t m, const source_point *listSources, int numSource)
+{
+    int isImage = options->format != FORMAT_TEXT;
+    if (isImage && openImage(image, options->format, n, m, options->imageSize, listSources, (size_t) numSource))
+    {
+        return 1;
+    }
+    openWriter(writer, out, isImage ? image : NULL, options->writer == WRITER_THREAD);
+    return 0;
+}
+
+/**
+ * calculate and print a grid stored as float, until it converges
+ * @param options the options, with the float or mixed precision
+ * @param listSources list of source
+ * @param numSource number of sources
+ * @param n width
+ * @param m length
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @return 0 if it's work and 1 if the grid can't be allocated or printed
+ */
+static int runFloatGrid(const SolverOptions *options, source_point *listSources, int numSource, int n, int m,
+                         double terminate, unsigned int n_iter, int is_cyclic)
+{
+    FloatGrid grid;
+    Output out;
+    GridWriter writer;
+    ImageStream image = {0, 0, 0, 0, 0, 0, NULL, NULL};
+    if (initFloatGrid(&grid, (size_t) n, (size_t) m) || openOutput(&out, STDOUT_FILENO, OUTPUT_BUFFER_SIZE))
+    {
+        fprintf(stderr, ERROR_MEMORY);
+        freeFloatGrid(&grid);
+        return 1;
+    }
+    if (startWriter(&writer, &out, &image, options, (size_t) n, (size_t) m, listSources, numSource))
+    {
+        fprintf(stderr, ERROR_MEMORY);
+        closeOutput(&out);
+        freeFloatGrid(&grid);
+        return 1;
+    }
+    for (int i = 0; i < numSource; ++i)
+    {
+        GRID_AT(&grid, listSources[i].x, listSources[i].y) = (float) listSources[i].value;
+    }
+    double delta = calculateFloatGrid(heat_eqn, &grid, listSources, (size_t) numSource, terminate, n_iter, is_cyclic,
+                                      options);
+    writeFloatGrid(&writer, &grid, delta);
+    while (delta > terminate || -delta > terminate)
+    {
+        delta = calculateFloatGrid(heat_eqn, &grid, listSources, (size_t) numSource, terminate, n_iter, is_cyclic,
+                                   options);
+        writeFloatGrid(&writer, &grid, delta);
+    }
+    closeWriter(&writer);
+    closeImage(&image);
+    int failed = closeOutput(&out);
+    freeFloatGrid(&grid);
+    return failed;
+}
+
+/**
+ * start the grid of a text input from a binary grid file instead of 0, with the sources of the input
+ * @param path the binary grid file
+ * @param grid the grid of the input, with its size
+ * @param listSources list of source
+ * @param numSource number of sources
+ * @param changes set to the points whose source is not the one of the file, to free
+ * @param numChanges set to the number of changes
+ * @return HEAT_OK or the error
+ */
+static int warmStart(const char *path, Grid *grid, const source_point *listSources, int numSource,
+                     source_point **changes, size_t *numChanges)
+{
+    Grid previous;
+    source_point *old;
+    size_t count;
+    GridFileInfo info;
+    if (loadGridFile(path, &previous, &old, &count, &info))
+    {
+        return HEAT_ERROR_WARM_START;
+    }
+    int error = previous.n != grid->n || previous.m != grid->m ? HEAT_ERROR_WARM_START : HEAT_OK;
+    *changes = NULL;
+    if (error == HEAT_OK)
+    {
+        *changes = (source_point *) malloc(sizeof(source_point) * (count + (size_t) numSource + 1));
+        if (*changes == NULL ||
+            findSourceChanges(&previous, old, count, listSources, (size_t) numSource, *changes, numChanges))
+        {
+            error = HEAT_ERROR_MEMORY;
+        }
+    }
+    for (size_t x = 0; x < grid->n && error == HEAT_OK; ++x)
+    {
+        memcpy(GRID_ROW(grid, x), GRID_ROW(&previous, x), sizeof(double) * grid->m);
+    }
+    if (error == HEAT_OK)
+    {
+        placeSources(grid, listSources, numSource);
+    }
+    else
+    {
+        free(*changes);
+        *changes = NULL;
+    }
+    freeGrid(&previous);
+    free(old);
+    return error;
+}
+
+/**
+ * The main function
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    Grid grid;
+    Output out;
+    GridWriter writer;
+    ImageStream image = {0, 0, 0, 0, 0, 0, NULL, NULL};
+    SolverOptions options;
+    SolverWorkspace workspace;
+    int first;
+    source_point *listSources, *changes = NULL;
+    int n, m, numSource = 0, is_cyclic;
+    double terminate;
+    unsigned int n_iter;
+
+    defaultOptions(&options);
+    if (readOptionsFromEnv(&options) || readOptionsFromArgs(&options, argc, argv, &first) ||
+        checkOptions(&options))
+    {
+        exit(1);
+    }
+    initProfile(options.profile);
+    if (first >= argc)
+    {
+        fprintf(stderr, USAGE);
+        exit(1);
+    }
+    if (isBatch(argv + first, argc - first))
+    {
+        return runBatch(&options, argv + first, argc - first);
+    }
+    if (isGridFile(argv[first]))
+    { // a binary grid, maybe a checkpoint to resume
+        GridFileInfo info;
+        size_t count;
+        if (loadGridFile(argv[first], &grid, &listSources, &count, &info))
+        {
+            fprintf(stderr, ERROR_GRID_FILE);
+            exit(1);
+        }
+        numSource = (int) count;
+        terminate = info.terminate;
+        n_iter = info.n_iter;
+        is_cyclic = info.is_cyclic;
+        options.resumeSweeps = info.sweeps;
+        options.resumeSum = info.sum;
+        options.resumeDelta = info.delta;
+    }
+    else
+    {
+        fp = fopen(argv[first], "r");
+        parseFile(fp, &n, &m, &listSources, &numSource, &terminate, &n_iter, &is_cyclic);
+        fclose(fp);
+        if (options.precision != PRECISION_DOUBLE && options.checkpoint == NULL && options.warmStart == NULL &&
+            options.save == NULL && options.outOfCore == NULL)
+        { // the grid is only allocated as float
+            if (runFloatGrid(&options, listSources, numSource, n, m, terminate, n_iter, is_cyclic))
+            {
+                closeAndFree(NULL, NULL, listSources, NULL);
+            }
+            free(listSources);
+            return 0;
+        }
+        if (options.outOfCore != NULL ? mapGrid(&grid, (size_t) n, (size_t) m, options.outOfCore)
+                                      : initGrid(&grid, (size_t) n, (size_t) m))
+        {
+            fprintf(stderr, options.outOfCore != NULL ? ERROR_MAP : ERROR_MEMORY);
+            closeAndFree(NULL, NULL, listSources, NULL);
+        }
+        placeSources(&grid, listSources, numSource);
+        int error = options.warmStart != NULL ? warmStart(options.warmStart, &grid, listSources, numSource, &changes,
+                                                          &options.numChanges) : HEAT_OK;
+        if (error != HEAT_OK)
+        {
+            fprintf(stderr, "%s", statusMessage(error));
+            closeAndFree(NULL, &grid, listSources, NULL);
+        }
+        options.changes = changes;
+        GridFileInfo info = {terminate, n_iter, is_cyclic, 0, 0, 0};
+        if (options.checkpoint != NULL &&
+            writeGridFile(options.checkpoint, &grid, listSources, (size_t) numSource, &info))
+        { // the input is saved first, the next runs can start from the binary file
+            fprintf(stderr, ERROR_CHECKPOINT);
+        }
+    }
+    if (openOutput(&out, STDOUT_FILENO, OUTPUT_BUFFER_SIZE) ||
+        startWriter(&writer, &out, &image, &options, grid.n, grid.m, listSources, numSource))
+    {
+        fprintf(stderr, ERROR_MEMORY);
+        closeAndFree(NULL, &grid, listSources, NULL);
+    }
+
+    memset(&workspace, 0, sizeof(SolverWorkspace));
+    options.workspace = &workspace; // the threads are kept from one call to the next
+    double delta = calculateGrid(heat_eqn, &grid, listSources, (size_t) numSource, terminate, n_iter, is_cyclic,
+                                 &options);
+    writeGrid(&writer, &grid, delta);
+    options.resumeSweeps = 0; // only the first call continues the checkpoint or starts from the changes
+    options.changes = NULL;
+
+    while (delta > terminate || -delta > terminate)
+    {
+        delta = calculateGrid(heat_eqn, &grid, listSources, (size_t) numSource, terminate, n_iter, is_cyclic,
+                              &options);
+        writeGrid(&writer, &grid, delta);
+    }
+    freeWorkspace(&workspace);
+    closeWriter(&writer);
+    closeImage(&image);
+    closeOutput(&out);
+    GridFileInfo info = {terminate, n_iter, is_cyclic, 0, 0, 0};
+    if (options.save != NULL && writeGridFile(options.save, &grid, listSources, (size_t) numSource, &info))
+    {
+        fprintf(stderr, ERROR_SAVE);
+    }
+    free(changes);
+    closeAndFree(NULL, &grid, listSources, NULL);
+    return 0;
+}
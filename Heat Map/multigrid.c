@@ -0,0 +1,465 @@
+/**
+ * @file multigrid.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief V-cycle multigrid for the runs which sweep until the grid converges
+ */
+
+// ------------------------------ includes --------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include "profile.h"
+#include "sweep.h"
+
+// -------------------------- const definitions -------------------------
+#define PRE_SWEEPS 2
+#define POST_SWEEPS 2
+#define COARSEST_SWEEPS 32
+#define COARSEST_SIZE 4
+#define MAX_LEVELS 32
+#define MAX_CYCLES 1000
+#define MIN_REDUCTION 0.9
+
+/**
+ * A coarse level: point (i, j) is the point (2i + 1, 2j + 1) of the level above, so the ghost layers of the two
+ * levels are on the same lines (exactly when the size above is odd). error is the correction of the level above, rhs
+ * the restricted residual of the level above, fixed tells which points are nearest to a source (their correction
+ * stays 0).
+ */
+typedef struct Level
+{
+    Grid error;
+    Grid rhs;
+    unsigned char *fixed;
+} Level;
+
+/**
+ * the levels of a solve, levels[0] being the first coarse level
+ */
+typedef struct Hierarchy
+{
+    Level levels[MAX_LEVELS];
+    int count;
+    int is_cyclic;
+} Hierarchy;
+
+// ------------------------------ functions -------------------------------
+/**
+ * free the levels
+ * @param hierarchy the levels
+ */
+static void freeHierarchy(Hierarchy *hierarchy)
+{
+    for (int l = 0; l < hierarchy->count; ++l)
+    {
+        freeGrid(&hierarchy->levels[l].error);
+        freeGrid(&hierarchy->levels[l].rhs);
+        free(hierarchy->levels[l].fixed);
+    }
+    hierarchy->count = 0;
+}
+
+/**
+ * build the coarse levels down to a few points, and mark the sources
+ * @param hierarchy the levels
+ * @param fixed the sources of the grid, n*m
+ * @param n width of the grid
+ * @param m length of the grid
+ * @return 0 if it's work and 1 if not
+ */
+static int buildHierarchy(Hierarchy *hierarchy, const unsigned char *fixed, size_t n, size_t m)
+{
+    hierarchy->count = 0;
+    while ((n > COARSEST_SIZE || m > COARSEST_SIZE) && n > 2 && m > 2 && hierarchy->count < MAX_LEVELS)
+    {
+        size_t cn = n / 2, cm = m / 2;
+        Level *level = &hierarchy->levels[hierarchy->count];
+        level->fixed = (unsigned char *) calloc(cn * cm, 1);
+        int failed = level->fixed == NULL || initGrid(&level->error, cn, cm);
+        if (!failed && initGrid(&level->rhs, cn, cm))
+        {
+            freeGrid(&level->error);
+            failed = 1;
+        }
+        if (failed)
+        {
+            free(level->fixed);
+            freeHierarchy(hierarchy);
+            return 1;
+        }
+        ++hierarchy->count;
+        for (size_t x = 0; x < n; ++x)
+        { // a source pins the nearest coarse point
+            for (size_t y = 0; y < m; ++y)
+            {
+                if (fixed[x * m + y])
+                {
+                    size_t i = x / 2 < cn ? x / 2 : cn - 1, j = y / 2 < cm ? y / 2 : cm - 1;
+                    level->fixed[i * cm + j] = 1;
+                }
+            }
+        }
+        fixed = level->fixed;
+        n = cn;
+        m = cm;
+    }
+    return 0;
+}
+
+/**
+ * Gauss-Seidel sweeps of a coarse level: each free point becomes the average of its neighbours plus its rhs
+ * @param level the level
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param sweeps number of sweeps
+ */
+static void smoothLevel(Level *level, int is_cyclic, int sweeps)
+{
+    Grid *error = &level->error;
+    ptrdiff_t stride = (ptrdiff_t) error->stride;
+    size_t n = error->n, m = error->m;
+    for (int k = 0; k < sweeps; ++k)
+    {
+        fillHalo(error, is_cyclic);
+        for (size_t x = 0; x < n; ++x)
+        {
+            double *row = GRID_ROW(error, x);
+            const double *rhs = GRID_ROW(&level->rhs, x);
+            const unsigned char *fixed = level->fixed + x * m;
+            for (size_t y = 0; y < m; ++y)
+            {
+                if (!fixed[y])
+                {
+                    row[y] = (row[y + 1] + row[y - stride] + row[y - 1] + row[y + stride]) * 0.25 + rhs[y];
+                }
+            }
+            if (is_cyclic && x == 0)
+            { // like calculateOneHalo, the last row reads the new first row
+                memcpy(GRID_ROW(error, n), row, sizeof(double) * m);
+            }
+        }
+    }
+}
+
+/**
+ * find the coarse lines a line of the level above is restricted to or interpolated from, with their weights
+ * an odd line is a coarse line, an even line is between two of them. Without cyclic edges a line past the last one
+ * is the ghost layer.
+ * @param x the line
+ * @param count number of coarse lines
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param lines set to the coarse lines, -1 and count being the ghost layer
+ * @return number of coarse lines, 1 or 2 (both with weight 1/2)
+ */
+static int coarseLines(size_t x, size_t count, int is_cyclic, ptrdiff_t lines[2])
+{
+    ptrdiff_t line = (ptrdiff_t) x / 2;
+    if (x % 2 == 1)
+    {
+        lines[0] = line;
+        return 1;
+    }
+    lines[0] = line - 1;
+    lines[1] = line;
+    if (is_cyclic && lines[0] < 0)
+    {
+        lines[0] = (ptrdiff_t) count - 1;
+    }
+    if (is_cyclic && lines[1] >= (ptrdiff_t) count)
+    {
+        lines[1] = 0;
+    }
+    return 2;
+}
+
+/**
+ * add the residual of a point to the rhs of the coarse points around it (full weighting)
+ * A coarse point is twice as far from its neighbours, so its equation is four times the average equation of the
+ * points around it: the weights of a point add up to 4 over the coarse points.
+ * @param coarse the coarse level
+ * @param x row of the point
+ * @param y column of the point
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param residual the residual of the point
+ */
+static void restrictPoint(Level *coarse, size_t x, size_t y, int is_cyclic, double residual)
+{
+    ptrdiff_t rows[2], cols[2];
+    ptrdiff_t n = (ptrdiff_t) coarse->rhs.n, m = (ptrdiff_t) coarse->rhs.m;
+    int rowCount = coarseLines(x, (size_t) n, is_cyclic, rows), colCount = coarseLines(y, (size_t) m, is_cyclic, cols);
+    double weight = residual * (rowCount == 1 ? 2 : 1) * (colCount == 1 ? 2 : 1) * 0.25;
+    for (int a = 0; a < rowCount; ++a)
+    {
+        for (int b = 0; b < colCount; ++b)
+        {
+            if (rows[a] >= 0 && rows[a] < n && cols[b] >= 0 && cols[b] < m)
+            {
+                GRID_AT(&coarse->rhs, rows[a], cols[b]) += weight;
+            }
+        }
+    }
+}
+
+/**
+ * the bilinear interpolation of a coarse grid at a point of the level above
+ * @param coarse the coarse grid, with its ghost layer filled
+ * @param x row of the point
+ * @param y column of the point
+ * @return the interpolated value
+ */
+static double prolongPoint(const Grid *coarse, size_t x, size_t y)
+{
+    ptrdiff_t rows[2], cols[2];
+    int rowCount = coarseLines(x, coarse->n, 0, rows), colCount = coarseLines(y, coarse->m, 0, cols);
+    double value = 0;
+    for (int a = 0; a < rowCount; ++a)
+    {
+        for (int b = 0; b < colCount; ++b)
+        {
+            value += GRID_AT(coarse, rows[a], cols[b]);
+        }
+    }
+    return value / (rowCount * colCount);
+}
+
+/**
+ * solve the correction of a coarse level with a V-cycle: smooth, hand the residual to the next level, add its
+ * correction and smooth again
+ * @param hierarchy the levels
+ * @param l the level, its rhs set
+ */
+static void vCycle(Hierarchy *hierarchy, int l)
+{
+    Level *level = &hierarchy->levels[l];
+    Grid *error = &level->error;
+    ptrdiff_t stride = (ptrdiff_t) error->stride;
+    size_t n = error->n, m = error->m;
+
+    for (size_t x = 0; x < n; ++x)
+    {
+        memset(GRID_ROW(error, x), 0, sizeof(double) * m);
+    }
+    if (l == hierarchy->count - 1)
+    {
+        smoothLevel(level, hierarchy->is_cyclic, COARSEST_SWEEPS);
+        return;
+    }
+    smoothLevel(level, hierarchy->is_cyclic, PRE_SWEEPS);
+    Level *coarse = &hierarchy->levels[l + 1];
+    for (size_t x = 0; x < coarse->rhs.n; ++x)
+    {
+        memset(GRID_ROW(&coarse->rhs, x), 0, sizeof(double) * coarse->rhs.m);
+    }
+    fillHalo(error, hierarchy->is_cyclic);
+    for (size_t x = 0; x < n; ++x)
+    {
+        const double *row = GRID_ROW(error, x), *rhs = GRID_ROW(&level->rhs, x);
+        for (size_t y = 0; y < m; ++y)
+        {
+            if (!level->fixed[x * m + y])
+            {
+                double average = (row[y + 1] + row[y - stride] + row[y - 1] + row[y + stride]) * 0.25;
+                restrictPoint(coarse, x, y, hierarchy->is_cyclic, rhs[y] + average - row[y]);
+            }
+        }
+    }
+    vCycle(hierarchy, l + 1);
+    fillHalo(&coarse->error, hierarchy->is_cyclic);
+    for (size_t x = 0; x < n; ++x)
+    {
+        for (size_t y = 0; y < m; ++y)
+        {
+            if (!level->fixed[x * m + y])
+            {
+                GRID_AT(error, x, y) += prolongPoint(&coarse->error, x, y);
+            }
+        }
+    }
+    smoothLevel(level, hierarchy->is_cyclic, POST_SWEEPS);
+}
+
+/**
+ * the residual of the grid (what a sweep would add to each point, with the old neighbours), restricted to the first
+ * coarse level
+ * @param state the sweep, with a grid with a ghost layer
+ * @param fixed the sources, n*m
+ * @param coarse the first coarse level
+ * @return the largest residual
+ */
+static double restrictResidual(const SweepState *state, const unsigned char *fixed, Level *coarse)
+{
+    Grid *grid = state->grid;
+    ptrdiff_t stride = (ptrdiff_t) grid->stride;
+    size_t n = grid->n, m = grid->m;
+    double largest = 0;
+
+    for (size_t x = 0; x < coarse->rhs.n; ++x)
+    {
+        memset(GRID_ROW(&coarse->rhs, x), 0, sizeof(double) * coarse->rhs.m);
+    }
+    fillHalo(grid, state->is_cyclic);
+    for (size_t x = 0; x < n; ++x)
+    {
+        const double *row = GRID_ROW(grid, x);
+        for (size_t y = 0; y < m; ++y)
+        {
+            if (!fixed[x * m + y])
+            {
+                double residual = state->function(row[y], row[y + 1], row[y - stride], row[y - 1], row[y + stride]) -
+                                  row[y];
+                restrictPoint(coarse, x, y, state->is_cyclic, residual);
+                largest = residual > largest ? residual : (-residual > largest ? -residual : largest);
+            }
+        }
+    }
+    return largest;
+}
+
+/**
+ * add the correction of the first coarse level to the grid
+ * The coarse levels only see the sources through the point nearest to each of them, so the size of the correction
+ * can be off around them. It is scaled by the step which reduces the error the most along it (the residual times the
+ * correction over the correction times the average stencil of the correction), which keeps the cycles converging.
+ * @param state the sweep, with the residual of the grid in its ghost layer filled
+ * @param fixed the sources of the grid
+ * @param coarse the correction of the first coarse level
+ * @param correction a grid of the size of the grid, set to the correction
+ */
+static void correctGrid(const SweepState *state, const unsigned char *fixed, Grid *coarse, Grid *correction)
+{
+    Grid *grid = state->grid;
+    ptrdiff_t stride = (ptrdiff_t) grid->stride, step = (ptrdiff_t) correction->stride;
+    size_t n = grid->n, m = grid->m;
+    double along = 0, curvature = 0;
+
+    fillHalo(coarse, state->is_cyclic);
+    for (size_t x = 0; x < n; ++x)
+    {
+        for (size_t y = 0; y < m; ++y)
+        {
+            GRID_AT(correction, x, y) = fixed[x * m + y] ? 0 : prolongPoint(coarse, x, y);
+        }
+    }
+    fillHalo(correction, state->is_cyclic);
+    for (size_t x = 0; x < n; ++x)
+    {
+        const double *row = GRID_ROW(grid, x), *c = GRID_ROW(correction, x);
+        for (size_t y = 0; y < m; ++y)
+        {
+            if (!fixed[x * m + y])
+            {
+                along += c[y] * (state->function(row[y], row[y + 1], row[y - stride], row[y - 1], row[y + stride]) -
+                                 row[y]);
+                curvature += c[y] * (c[y] - (c[y + 1] + c[y - step] + c[y - 1] + c[y + step]) * 0.25);
+            }
+        }
+    }
+    double scale = curvature > 0 ? along / curvature : 0;
+    for (size_t x = 0; x < n; ++x)
+    {
+        double *row = GRID_ROW(grid, x);
+        const double *c = GRID_ROW(correction, x);
+        for (size_t y = 0; y < m; ++y)
+        {
+            row[y] += scale * c[y];
+        }
+    }
+}
+
+/**
+ * calculate the grid with V-cycles until the difference between the sums of two cycles is below terminate
+ * The grid is smoothed by the sweep of the call, so the sources and the edges are handled as in the other modes and
+ * the grid converges to the same values. The coarse levels correct the smooth part of the error, which the sweeps
+ * only move by one point per sweep: their equation is the average stencil, each source fixes the nearest coarse point
+ * at 0 and the edges are cyclic or 0 like the grid. If the cycles don't reduce the residual (a heat function far from
+ * the average) they stop and the caller goes on with sweeps.
+ * @param state the sweep, with a grid with a ghost layer
+ * @param sweep the sweep
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param sum set to the sum of the points after the last sweep
+ * @param delta set to the difference between the sums of the two last cycles
+ * @return the number of sweeps of the grid done, 0 if the grid is too small or there is not enough memory
+ */
+unsigned long calculateMultigrid(SweepState *state, double (*sweep)(SweepState *), const source_point *sources,
+                                 size_t num_sources, double terminate, double *sum, double *delta)
+{
+    Grid *grid = state->grid;
+    size_t n = grid->n, m = grid->m;
+    Hierarchy hierarchy;
+    Grid correction;
+    unsigned long sweeps = 0;
+    double previousSum = 0, residuals[2] = {0, 0};
+    ProfileMark mark;
+    unsigned char *fixed = (unsigned char *) calloc(n * m + 1, 1);
+
+    if (fixed == NULL)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < num_sources; ++i)
+    {
+        if (sources[i].x >= 0 && sources[i].y >= 0 && (size_t) sources[i].x < n && (size_t) sources[i].y < m)
+        {
+            fixed[(size_t) sources[i].x * m + (size_t) sources[i].y] = 1;
+        }
+    }
+    if (initGrid(&correction, n, m))
+    {
+        free(fixed);
+        return 0;
+    }
+    if (buildHierarchy(&hierarchy, fixed, n, m) || hierarchy.count == 0)
+    {
+        freeGrid(&correction);
+        free(fixed);
+        return 0;
+    }
+    hierarchy.is_cyclic = state->is_cyclic;
+    for (int cycle = 0; cycle < MAX_CYCLES; ++cycle)
+    {
+        unsigned long first = sweeps;
+        if (profileLevel)
+        {
+            profileMark(&mark);
+        }
+        for (int k = 0; k < PRE_SWEEPS; ++k, ++sweeps)
+        {
+            sweep(state);
+        }
+        double residual = restrictResidual(state, fixed, &hierarchy.levels[0]);
+        if (cycle > 1 && residual > residuals[cycle & 1] * MIN_REDUCTION)
+        { // the coarse levels don't help this heat function (the residual of one cycle can go up a bit)
+            *sum = sweep(state);
+            *delta = *sum - previousSum;
+            ++sweeps;
+            if (profileLevel)
+            {
+                profileSweepBlock(&mark, sweeps - first, *delta);
+            }
+            break;
+        }
+        residuals[cycle & 1] = residual;
+        vCycle(&hierarchy, 0);
+        correctGrid(state, fixed, &hierarchy.levels[0].error, &correction);
+        for (int k = 0; k < POST_SWEEPS; ++k, ++sweeps)
+        {
+            *sum = sweep(state);
+        }
+        *delta = *sum - previousSum;
+        previousSum = *sum;
+        if (profileLevel)
+        {
+            profileSweepBlock(&mark, sweeps - first, *delta);
+        }
+        if (!(*delta > terminate || -*delta > terminate))
+        {
+            break;
+        }
+    }
+    freeHierarchy(&hierarchy);
+    freeGrid(&correction);
+    free(fixed);
+    return sweeps;
+}
@@ -0,0 +1,610 @@
+/**
+ * @file options.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief read the solver options from the command line and the environment
+ */
+#define _POSIX_C_SOURCE 200112L
+
+// ------------------------------ includes --------------------------------
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "profile.h"
+#include "solver.h"
+#include "stencil.h"
+
+// -------------------------- const definitions -------------------------
+#define ENV_PREFIX "HEAT_"
+#define ARG_PREFIX "--"
+#define MAX_NAME 64
+#define MAX_THREADS 1024
+#define MAX_PROCESSES 256
+#define MAX_BLOCK_SWEEPS 4096
+#define MAX_OMEGA 2.0
+#define DEFAULT_CHECKPOINT_EVERY 1000
+#define DEFAULT_IMAGE_SIZE 512
+#define ERROR_OPTION "Error with option: %s.\n"
+#define ERROR_OPTIONS "Error with options: %s\n"
+
+/**
+ * an option: its name and the function which store its value
+ */
+typedef struct Option
+{
+    const char *name;
+    int (*parse)(SolverOptions *options, const char *value);
+} Option;
+
+// ------------------------------ functions -------------------------------
+/**
+ * read a number without a sign at the start of a value, as strtoul does but without its spaces and minus sign
+ * @param value the value
+ * @param number set to the number
+ * @param end set to the first character after the number
+ * @return 0 if it's work and 1 if the value doesn't start with a digit or the number is too large
+ */
+static int readUnsigned(const char *value, unsigned long *number, char **end)
+{
+    if (!isdigit((unsigned char) *value))
+    {
+        return 1;
+    }
+    errno = 0;
+    *number = strtoul(value, end, 10);
+    return errno == ERANGE;
+}
+
+/**
+ * find a value in a list of names
+ * @param value the value
+ * @param names the names, the i-th name stands for the value i
+ * @param count number of names
+ * @param result set to the index of the name
+ * @return 0 if it's work and 1 if the value is not in the list
+ */
+static int parseChoice(const char *value, const char *const names[], int count, int *result)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (strcmp(value, names[i]) == 0)
+        {
+            *result = i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * parse the boundary option
+ * @param options the options
+ * @param value halo or branch
+ * @return 0 if it's work and 1 if not
+ */
+static int parseBoundary(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"halo", "branch"};
+    return parseChoice(value, names, 2, &options->boundary);
+}
+
+/**
+ * parse the order option
+ * @param options the options
+ * @param value column, row, tiled or redblack
+ * @return 0 if it's work and 1 if not
+ */
+static int parseOrder(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"column", "row", "tiled", "redblack"};
+    return parseChoice(value, names, 4, &options->order);
+}
+
+/**
+ * parse the stencil option
+ * @param options the options
+ * @param value function, average, weighted or nine-point
+ * @return 0 if it's work and 1 if not
+ */
+static int parseStencil(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"function", "average", "weighted", "nine-point"};
+    return parseChoice(value, names, 4, &options->stencil);
+}
+
+/**
+ * parse the simd option
+ * @param options the options
+ * @param value auto, scalar, sse2 or avx2
+ * @return 0 if it's work and 1 if not
+ */
+static int parseSimd(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"auto", "scalar", "sse2", "avx2"};
+    return parseChoice(value, names, 4, &options->simd);
+}
+
+/**
+ * parse the solver option
+ * @param options the options
+ * @param value sweep or multigrid
+ * @return 0 if it's work and 1 if not
+ */
+static int parseSolver(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"sweep", "multigrid"};
+    return parseChoice(value, names, 2, &options->solver);
+}
+
+/**
+ * parse the sum option
+ * @param options the options
+ * @param value sweep or pairwise
+ * @return 0 if it's work and 1 if not
+ */
+static int parseSum(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"sweep", "pairwise"};
+    return parseChoice(value, names, 2, &options->sum);
+}
+
+/**
+ * parse the precision option
+ * @param options the options
+ * @param value double, float or mixed
+ * @return 0 if it's work and 1 if not
+ */
+static int parsePrecision(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"double", "float", "mixed"};
+    return parseChoice(value, names, 3, &options->precision);
+}
+
+/**
+ * parse the jobs option
+ * @param options the options
+ * @param value number of inputs solved at the same time, 0 for one per CPU
+ * @return 0 if it's work and 1 if not
+ */
+static int parseJobs(SolverOptions *options, const char *value)
+{
+    int jobs;
+    char end;
+    if (sscanf(value, "%d%c", &jobs, &end) != 1 || jobs < 0 || jobs > MAX_THREADS)
+    {
+        return 1;
+    }
+    if (jobs == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cpus > 0 ? (int) cpus : 1;
+    }
+    options->jobs = jobs;
+    return 0;
+}
+
+/**
+ * parse the output-dir option
+ * @param options the options
+ * @param value the directory, kept as it is
+ * @return 0 if it's work and 1 if not
+ */
+static int parseOutputDir(SolverOptions *options, const char *value)
+{
+    if (*value == '\0')
+    {
+        return 1;
+    }
+    options->outputDir = value;
+    return 0;
+}
+
+/**
+ * parse the profile option
+ * @param options the options
+ * @param value none, summary or trace
+ * @return 0 if it's work and 1 if not
+ */
+static int parseProfile(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"none", "summary", "trace"};
+    return parseChoice(value, names, 3, &options->profile);
+}
+
+/**
+ * parse the tile option
+ * @param options the options
+ * @param value rows x columns, like 64x512
+ * @return 0 if it's work and 1 if not
+ */
+static int parseTile(SolverOptions *options, const char *value)
+{
+    unsigned long rows, cols;
+    char *end;
+    if (readUnsigned(value, &rows, &end) || *end != 'x' || readUnsigned(end + 1, &cols, &end) || *end != '\0')
+    {
+        return 1;
+    }
+    options->tileRows = (size_t) rows;
+    options->tileCols = (size_t) cols;
+    return 0;
+}
+
+/**
+ * parse the active option
+ * @param options the options
+ * @param value off, or the largest change of a point which leaves its tile unchanged
+ * @return 0 if it's work and 1 if not
+ */
+static int parseActive(SolverOptions *options, const char *value)
+{
+    double threshold;
+    char end;
+    if (strcmp(value, "off") == 0)
+    {
+        options->activeThreshold = ACTIVE_OFF;
+        return 0;
+    }
+    if (sscanf(value, "%lf%c", &threshold, &end) != 1 || !(threshold >= 0))
+    {
+        return 1;
+    }
+    options->activeThreshold = threshold;
+    return 0;
+}
+
+/**
+ * parse the omega option
+ * @param options the options
+ * @param value auto, or the over-relaxation factor, above 0 and below 2
+ * @return 0 if it's work and 1 if not
+ */
+static int parseOmega(SolverOptions *options, const char *value)
+{
+    double omega;
+    char end;
+    if (strcmp(value, "auto") == 0)
+    {
+        options->omega = OMEGA_AUTO;
+        return 0;
+    }
+    if (sscanf(value, "%lf%c", &omega, &end) != 1 || !(omega > 0 && omega < MAX_OMEGA))
+    {
+        return 1;
+    }
+    options->omega = omega;
+    return 0;
+}
+
+/**
+ * parse the threads option
+ * @param options the options
+ * @param value number of threads, 0 for one per CPU
+ * @return 0 if it's work and 1 if not
+ */
+static int parseThreads(SolverOptions *options, const char *value)
+{
+    int threads;
+    char end;
+    if (sscanf(value, "%d%c", &threads, &end) != 1 || threads < 0 || threads > MAX_THREADS)
+    {
+        return 1;
+    }
+    if (threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int) cpus : 1;
+    }
+    options->threads = threads;
+    return 0;
+}
+
+/**
+ * parse the processes option
+ * @param options the options
+ * @param value number of processes, 0 for one per NUMA node
+ * @return 0 if it's work and 1 if not
+ */
+static int parseProcesses(SolverOptions *options, const char *value)
+{
+    int processes;
+    char end;
+    if (sscanf(value, "%d%c", &processes, &end) != 1 || processes < 0 || processes > MAX_PROCESSES)
+    {
+        return 1;
+    }
+    options->processes = processes;
+    return 0;
+}
+
+/**
+ * parse the block-sweeps option
+ * @param options the options
+ * @param value number of sweeps done together, 0 to choose it from the cache
+ * @return 0 if it's work and 1 if not
+ */
+static int parseBlockSweeps(SolverOptions *options, const char *value)
+{
+    unsigned long sweeps;
+    char *end;
+    if (readUnsigned(value, &sweeps, &end) || *end != '\0' || sweeps > MAX_BLOCK_SWEEPS)
+    {
+        return 1;
+    }
+    options->blockSweeps = (size_t) sweeps;
+    return 0;
+}
+
+/**
+ * parse the checkpoint option
+ * @param options the options
+ * @param value the file, kept as it is
+ * @return 0 if it's work and 1 if not
+ */
+static int parseCheckpoint(SolverOptions *options, const char *value)
+{
+    if (*value == '\0')
+    {
+        return 1;
+    }
+    options->checkpoint = value;
+    return 0;
+}
+
+/**
+ * parse the checkpoint-every option
+ * @param options the options
+ * @param value number of sweeps between two checkpoints
+ * @return 0 if it's work and 1 if not
+ */
+static int parseCheckpointEvery(SolverOptions *options, const char *value)
+{
+    unsigned long sweeps;
+    char *end;
+    if (readUnsigned(value, &sweeps, &end) || *end != '\0' || sweeps == 0)
+    {
+        return 1;
+    }
+    options->checkpointEvery = sweeps;
+    return 0;
+}
+
+/**
+ * parse the warm-start option
+ * @param options the options
+ * @param value the binary grid file, kept as it is
+ * @return 0 if it's work and 1 if not
+ */
+static int parseWarmStart(SolverOptions *options, const char *value)
+{
+    if (*value == '\0')
+    {
+        return 1;
+    }
+    options->warmStart = value;
+    return 0;
+}
+
+/**
+ * parse the save option
+ * @param options the options
+ * @param value the binary grid file, kept as it is
+ * @return 0 if it's work and 1 if not
+ */
+static int parseSave(SolverOptions *options, const char *value)
+{
+    if (*value == '\0')
+    {
+        return 1;
+    }
+    options->save = value;
+    return 0;
+}
+
+/**
+ * parse the writer option
+ * @param options the options
+ * @param value inline or thread
+ * @return 0 if it's work and 1 if not
+ */
+static int parseWriter(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"inline", "thread"};
+    return parseChoice(value, names, 2, &options->writer);
+}
+
+/**
+ * parse the format option
+ * @param options the options
+ * @param value text, pgm or ppm
+ * @return 0 if it's work and 1 if not
+ */
+static int parseFormat(SolverOptions *options, const char *value)
+{
+    static const char *const names[] = {"text", "pgm", "ppm"};
+    return parseChoice(value, names, 3, &options->format);
+}
+
+/**
+ * parse the image-size option
+ * @param options the options
+ * @param value the largest side of the frames in pixels, 0 for a pixel per point
+ * @return 0 if it's work and 1 if not
+ */
+static int parseImageSize(SolverOptions *options, const char *value)
+{
+    unsigned long size;
+    char *end;
+    if (readUnsigned(value, &size, &end) || *end != '\0')
+    {
+        return 1;
+    }
+    options->imageSize = (size_t) size;
+    return 0;
+}
+
+/**
+ * parse the out-of-core option
+ * @param options the options
+ * @param value the directory of the file of the grid, kept as it is
+ * @return 0 if it's work and 1 if not
+ */
+static int parseOutOfCore(SolverOptions *options, const char *value)
+{
+    if (*value == '\0')
+    {
+        return 1;
+    }
+    options->outOfCore = value;
+    return 0;
+}
+
+static const Option OPTIONS[] = {
+        {"boundary", parseBoundary},
+        {"order", parseOrder},
+        {"tile", parseTile},
+        {"stencil", parseStencil},
+        {"simd", parseSimd},
+        {"active", parseActive},
+        {"threads", parseThreads},
+        {"processes", parseProcesses},
+        {"block-sweeps", parseBlockSweeps},
+        {"solver", parseSolver},
+        {"omega", parseOmega},
+        {"sum", parseSum},
+        {"precision", parsePrecision},
+        {"checkpoint", parseCheckpoint},
+        {"checkpoint-every", parseCheckpointEvery},
+        {"profile", parseProfile},
+        {"jobs", parseJobs},
+        {"output-dir", parseOutputDir},
+        {"warm-start", parseWarmStart},
+        {"save", parseSave},
+        {"writer", parseWriter},
+        {"format", parseFormat},
+        {"image-size", parseImageSize},
+        {"out-of-core", parseOutOfCore},
+};
+
+#define NUM_OPTIONS (sizeof(OPTIONS) / sizeof(OPTIONS[0]))
+
+/**
+ * set the default options
+ * @param options the options
+ */
+void defaultOptions(SolverOptions *options)
+{
+    options->boundary = BOUNDARY_HALO;
+    options->order = ORDER_COLUMN;
+    options->tileRows = 0;
+    options->tileCols = 0;
+    options->stencil = STENCIL_FUNCTION;
+    options->simd = SIMD_AUTO;
+    options->activeThreshold = ACTIVE_OFF;
+    options->threads = 1;
+    options->processes = 1;
+    options->blockSweeps = 0;
+    options->solver = SOLVER_SWEEP;
+    options->omega = OMEGA_GAUSS_SEIDEL;
+    options->sum = SUM_SWEEP;
+    options->precision = PRECISION_DOUBLE;
+    options->checkpoint = NULL;
+    options->checkpointEvery = DEFAULT_CHECKPOINT_EVERY;
+    options->profile = PROFILE_NONE;
+    options->jobs = 0;
+    options->outputDir = NULL;
+    options->warmStart = NULL;
+    options->save = NULL;
+    options->writer = WRITER_INLINE;
+    options->format = FORMAT_TEXT;
+    options->imageSize = DEFAULT_IMAGE_SIZE;
+    options->outOfCore = NULL;
+    options->sweeps = NULL;
+    options->workspace = NULL;
+    options->progress = NULL;
+    options->progressData = NULL;
+    options->changes = NULL;
+    options->numChanges = 0;
+    options->resumeSweeps = 0;
+    options->resumeSum = 0;
+    options->resumeDelta = 0;
+}
+
+/**
+ * read the options from the HEAT_* environment variables, the name of the variable of --some-option is
+ * HEAT_SOME_OPTION
+ * @param options the options
+ * @return 0 if it's work and 1 if a variable has a bad value
+ */
+int readOptionsFromEnv(SolverOptions *options)
+{
+    char name[MAX_NAME];
+    for (size_t i = 0; i < NUM_OPTIONS; ++i)
+    {
+        size_t len = strlen(ENV_PREFIX);
+        strcpy(name, ENV_PREFIX);
+        for (const char *c = OPTIONS[i].name; *c != '\0' && len + 1 < MAX_NAME; ++c)
+        {
+            name[len++] = *c == '-' ? '_' : (char) toupper((unsigned char) *c);
+        }
+        name[len] = '\0';
+        const char *value = getenv(name);
+        if (value != NULL && OPTIONS[i].parse(options, value))
+        {
+            fprintf(stderr, ERROR_OPTION, name);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * read the --name=value options at the start of the command line
+ * @param options the options
+ * @param argc number of arguments
+ * @param argv the arguments
+ * @param first set to the index of the first argument which is not an option
+ * @return 0 if it's work and 1 if an option is unknown or has a bad value
+ */
+int readOptionsFromArgs(SolverOptions *options, int argc, char *argv[], int *first)
+{
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], ARG_PREFIX, strlen(ARG_PREFIX)) == 0; ++arg)
+    {
+        const char *name = argv[arg] + strlen(ARG_PREFIX);
+        const char *value = strchr(name, '=');
+        size_t i = 0;
+        while (value != NULL && i < NUM_OPTIONS &&
+               (strncmp(OPTIONS[i].name, name, (size_t) (value - name)) != 0 ||
+                OPTIONS[i].name[value - name] != '\0'))
+        {
+            ++i;
+        }
+        if (value == NULL || i == NUM_OPTIONS || OPTIONS[i].parse(options, value + 1))
+        {
+            fprintf(stderr, ERROR_OPTION, argv[arg]);
+            return 1;
+        }
+    }
+    *first = arg;
+    return 0;
+}
+
+/**
+ * tell if the options can be used together, and report the ones which can't on stderr
+ * @param options the options, read from the environment and the command line
+ * @return 0 if they can and 1 if not
+ */
+int checkOptions(const SolverOptions *options)
+{
+    if (options->precision != PRECISION_DOUBLE && findStencil(options->stencil)->diagonals)
+    { // the float sweeps only have the 5-point stencils
+        fprintf(stderr, ERROR_OPTIONS, statusMessage(HEAT_ERROR_PRECISION));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * @file output.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief buffered output of numbers in fixed notation, written with write() in large blocks
+ */
+#define _POSIX_C_SOURCE 200112L
+
+// ------------------------------ includes --------------------------------
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+
+// -------------------------- const definitions -------------------------
+#define MAX_PRECISION 9
+#define MAX_FIXED 400
+#define EXACT_LIMIT 9007199254740992.0
+#define SPLITTER 134217729.0
+#define TIE_MARGIN 0.4999999
+
+static const double POWERS[MAX_PRECISION + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+// ------------------------------ functions -------------------------------
+/**
+ * start an output on a file descriptor
+ * stdout is flushed first, so what was printed with stdio comes before
+ * @param out the output
+ * @param fd the file descriptor
+ * @param capacity size of the buffer
+ * @return 0 if it's work and 1 if not
+ */
+int openOutput(Output *out, int fd, size_t capacity)
+{
+    fflush(stdout);
+    out->fd = fd;
+    out->length = 0;
+    out->capacity = capacity > MAX_FIXED * 2 ? capacity : MAX_FIXED * 2;
+    out->failed = 0;
+    out->buffer = (char *) malloc(out->capacity);
+    return out->buffer == NULL;
+}
+
+/**
+ * write what is in the buffer
+ * @param out the output
+ * @return 0 if it's work and 1 if a write failed
+ */
+int flushOutput(Output *out)
+{
+    size_t done = 0;
+    while (!out->failed && done < out->length)
+    {
+        ssize_t written = write(out->fd, out->buffer + done, out->length - done);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            out->failed = 1;
+            break;
+        }
+        done += (size_t) written;
+    }
+    out->length = 0;
+    return out->failed;
+}
+
+/**
+ * make room in the buffer
+ * @param out the output
+ * @param size number of bytes needed
+ */
+static void reserve(Output *out, size_t size)
+{
+    if (out->length + size > out->capacity)
+    {
+        flushOutput(out);
+    }
+}
+
+/**
+ * multiply two doubles exactly: a * b == product + error (Dekker's product, without fma)
+ * @param a first number, small enough not to overflow when it's split
+ * @param b second number
+ * @param error set to the part of the product the rounding lost
+ * @return the rounded product
+ */
+static double exactProduct(double a, double b, double *error)
+{
+    double product = a * b;
+    double ca = SPLITTER * a, cb = SPLITTER * b;
+    double aHigh = ca - (ca - a), aLow = a - aHigh;
+    double bHigh = cb - (cb - b), bLow = b - bHigh;
+    *error = ((aHigh * bHigh - product) + aHigh * bLow + aLow * bHigh) + aLow * bLow;
+    return product;
+}
+
+/**
+ * round a positive number times 10^precision to the nearest integer, like printf does
+ * @param value the number
+ * @param precision number of digits after the point
+ * @param rounded set to the integer
+ * @return 0 if it's sure and 1 if the number is too big or too close to a tie, printf must do it
+ */
+static int roundScaled(double value, int precision, uint64_t *rounded)
+{
+    double error, scaled = exactProduct(value, POWERS[precision], &error);
+    if (!(scaled < EXACT_LIMIT))
+    { // also true for inf and nan
+        return 1;
+    }
+    double nearest = (double) (uint64_t) (scaled + 0.5);
+    double rest = (scaled - nearest) + error; // value * 10^precision - nearest, up to a last bit
+    if (rest > TIE_MARGIN || rest < -TIE_MARGIN)
+    {
+        return 1;
+    }
+    *rounded = (uint64_t) nearest;
+    return 0;
+}
+
+/**
+ * write a number like printf("%.*f", precision, value) does
+ * the number is scaled and rounded to an integer, and the digits of the integer are written with the point put back.
+ * The rounding is checked with the exact product, numbers which can't be done exactly this way (too big, not
+ * finite or a tie at the last digit) go through snprintf, so the text is always the one of printf.
+ * @param out the output
+ * @param value the number
+ * @param precision number of digits after the point, at most 9
+ */
+void outputFixed(Output *out, double value, int precision)
+{
+    char digits[24];
+    uint64_t rounded;
+    int count = 0;
+
+    reserve(out, MAX_FIXED);
+    if (precision < 0 || precision > MAX_PRECISION || roundScaled(signbit(value) ? -value : value, precision, &rounded))
+    {
+        int length = snprintf(out->buffer + out->length, MAX_FIXED, "%.*f", precision, value);
+        out->length += length > 0 && length < MAX_FIXED ? (size_t) length : 0;
+        return;
+    }
+    do
+    {
+        digits[count++] = (char) ('0' + rounded % 10);
+        rounded /= 10;
+    } while (rounded > 0 || count <= precision);
+    char *end = out->buffer + out->length;
+    if (signbit(value))
+    {
+        *end++ = '-';
+    }
+    while (count > precision)
+    {
+        *end++ = digits[--count];
+    }
+    if (precision > 0)
+    {
+        *end++ = '.';
+        while (count > 0)
+        {
+            *end++ = digits[--count];
+        }
+    }
+    out->length = (size_t) (end - out->buffer);
+}
+
+/**
+ * write one character
+ * @param out the output
+ * @param c the character
+ */
+void outputChar(Output *out, char c)
+{
+    reserve(out, 1);
+    out->buffer[out->length++] = c;
+}
+
+/**
+ * write raw bytes
+ * what doesn't fit in the buffer is written in pieces of its size
+ * @param out the output
+ * @param bytes the bytes
+ * @param size number of bytes
+ */
+void outputBytes(Output *out, const void *bytes, size_t size)
+{
+    const char *next = (const char *) bytes;
+    while (size > 0)
+    {
+        reserve(out, size < out->capacity ? size : out->capacity);
+        size_t piece = out->capacity - out->length < size ? out->capacity - out->length : size;
+        memcpy(out->buffer + out->length, next, piece);
+        out->length += piece;
+        next += piece;
+        size -= piece;
+    }
+}
+
+/**
+ * flush and free the output (the file descriptor stays open)
+ * @param out the output
+ * @return 0 if it's work and 1 if a write failed
+ */
+int closeOutput(Output *out)
+{
+    int failed = flushOutput(out);
+    free(out->buffer);
+    out->buffer = NULL;
+    return failed;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file output.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief buffered output of numbers in fixed notation, written with write() in large blocks
+ */
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+// ------------------------------ includes --------------------------------
+#include <stddef.h>
+
+// -------------------------- const definitions -------------------------
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+/**
+ * An output buffer on a file descriptor. failed is set once a write fails, the next writes are then dropped.
+ */
+typedef struct Output
+{
+    int fd;
+    char *buffer;
+    size_t length;
+    size_t capacity;
+    int failed;
+} Output;
+
+// ------------------------------ functions -------------------------------
+/**
+ * start an output on a file descriptor
+ * stdout is flushed first, so what was printed with stdio comes before
+ * @param out the output
+ * @param fd the file descriptor
+ * @param capacity size of the buffer
+ * @return 0 if it's work and 1 if not
+ */
+int openOutput(Output *out, int fd, size_t capacity);
+
+/**
+ * write a number like printf("%.*f", precision, value) does
+ * @param out the output
+ * @param value the number
+ * @param precision number of digits after the point, at most 9
+ */
+void outputFixed(Output *out, double value, int precision);
+
+/**
+ * write one character
+ * @param out the output
+ * @param c the character
+ */
+void outputChar(Output *out, char c);
+
+/**
+ * write raw bytes
+ * @param out the output
+ * @param bytes the bytes
+ * @param size number of bytes
+ */
+void outputBytes(Output *out, const void *bytes, size_t size);
+
+/**
+ * write what is in the buffer
+ * @param out the output
+ * @return 0 if it's work and 1 if a write failed
+ */
+int flushOutput(Output *out);
+
+/**
+ * flush and free the output (the file descriptor stays open)
+ * @param out the output
+ * @return 0 if it's work and 1 if a write failed
+ */
+int closeOutput(Output *out);
+
+#endif //OUTPUT_H
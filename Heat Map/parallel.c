@@ -0,0 +1,135 @@
+/**
+ * @file parallel.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief red-black sweeps split in bands of rows between the threads of the pool
+ */
+
+// ------------------------------ includes --------------------------------
+#include <stdlib.h>
+#include "pool.h"
+#include "profile.h"
+#include "sum.h"
+#include "sweep.h"
+
+/**
+ * What the workers share during a call: each worker writes only its own bandSum (or its rows of state->rowSums), worker
+ * 0 adds them up in the order of the bands (pairwise in the order of the rows) and decides if there is another sweep.
+ */
+typedef struct ParallelSolve
+{
+    SweepState *state;
+    Pool *pool;
+    double terminate;
+    unsigned int n_iter;
+    double *bandSum;
+    double delta;
+    unsigned long sweeps;
+    int done;
+} ParallelSolve;
+
+// ------------------------------ functions -------------------------------
+/**
+ * sweep the band of rows of one worker until the solve is done
+ * the halo is filled by worker 0 while the others wait at the barrier, so no worker reads it half written
+ * @param arg the solve
+ * @param worker the number of the worker
+ * @param workers number of workers
+ */
+static void solveBand(void *arg, int worker, int workers)
+{
+    ParallelSolve *solve = (ParallelSolve *) arg;
+    SweepState *state = solve->state;
+    int n = (int) state->grid->n;
+    int from = (int) ((long) n * worker / workers), to = (int) ((long) n * (worker + 1) / workers);
+    double sum = 0, previousSum = 0;
+    ProfileMark mark;
+
+    while (!solve->done)
+    {
+        if (worker == 0 && profileLevel)
+        { // the sweep starts when the workers leave the barrier of the last one
+            profileMark(&mark);
+        }
+        if (worker == 0)
+        {
+            fillHalo(state->grid, state->is_cyclic);
+        }
+        poolBarrier(solve->pool);
+        redBlackPass(state, RED, from, to);
+        poolBarrier(solve->pool);
+        if (state->is_cyclic)
+        { // the black points of the edges read red points across the grid
+            if (worker == 0)
+            {
+                fillHalo(state->grid, state->is_cyclic);
+            }
+            poolBarrier(solve->pool);
+        }
+        solve->bandSum[worker] = redBlackPass(state, BLACK, from, to);
+        poolBarrier(solve->pool);
+        if (worker == 0)
+        {
+            previousSum = sum;
+            sum = 0;
+            if (state->rowSums != NULL)
+            { // the same sum for any number of workers
+                sum = pairwiseSum(state->rowSums, state->grid->n);
+            }
+            for (int i = 0; i < workers && state->rowSums == NULL; ++i)
+            {
+                sum += solve->bandSum[i];
+            }
+            solve->delta = sum - previousSum;
+            ++solve->sweeps;
+            if (profileLevel)
+            {
+                profileSweep(&mark, solve->delta);
+            }
+            if (solve->n_iter > 0)
+            {
+                solve->done = solve->sweeps >= solve->n_iter;
+            }
+            else
+            {
+                solve->done = !(solve->delta > solve->terminate || -solve->delta > solve->terminate);
+            }
+        }
+        poolBarrier(solve->pool);
+    }
+}
+
+/**
+ * calculate the grid with a red-black sweep split in bands of rows between the threads of the pool, until n_iter
+ * sweeps are done or the difference between the sums of two sweeps is below terminate (if n_iter is 0).
+ * The pool is started on the first call and kept in *pool for the next ones.
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @param pool the pool of the caller, NULL to start one for this call only
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param threads number of threads
+ * @param delta set to the difference between the sums of the two last sweeps
+ * @param sweeps set to the number of sweeps done
+ * @return 0 if it's work and 1 if the pool can't be started
+ */
+int calculateParallel(SweepState *state, Pool **pool, double terminate, unsigned int n_iter, int threads,
+                      double *delta, unsigned long *sweeps)
+{
+    Pool *own = NULL;
+    Pool **used = pool != NULL ? pool : &own;
+    ParallelSolve solve = {state, NULL, terminate, n_iter, NULL, 0, 0, 0};
+    solve.bandSum = (double *) calloc((size_t) threads, sizeof(double));
+    if (solve.bandSum == NULL || startPool(used, threads))
+    {
+        free(solve.bandSum);
+        return 1;
+    }
+    solve.pool = *used;
+    runPool(solve.pool, solveBand, &solve);
+    stopPool(&own);
+    free(solve.bandSum);
+    *delta = solve.delta;
+    *sweeps = solve.sweeps;
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file pool.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief pool of worker threads kept alive between the calls of the calculator
+ */
+#define _POSIX_C_SOURCE 200112L
+
+// ------------------------------ includes --------------------------------
+#include <pthread.h>
+#include <stdlib.h>
+#include "pool.h"
+
+/**
+ * What a thread of the pool is given: its pool and its number.
+ */
+typedef struct PoolWorker
+{
+    struct Pool *pool;
+    int worker;
+} PoolWorker;
+
+/**
+ * The pool: the threads wait under lock for a new generation of task, run it, and meet at the done barrier.
+ */
+struct Pool
+{
+    pthread_t *threads;
+    PoolWorker *args;
+    int workers;
+    pthread_barrier_t barrier;
+    pthread_barrier_t done;
+    unsigned long generation;
+    int stop;
+    PoolTask task;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+};
+
+// ------------------------------ functions -------------------------------
+/**
+ * body of the threads of the pool
+ * @param arg the PoolWorker of the thread
+ * @return NULL
+ */
+static void *workerMain(void *arg)
+{
+    Pool *pool = ((PoolWorker *) arg)->pool;
+    int worker = ((PoolWorker *) arg)->worker;
+    unsigned long seen = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stop && pool->generation == seen)
+        {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        PoolTask task = pool->task;
+        void *taskArg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        task(taskArg, worker, pool->workers);
+        pthread_barrier_wait(&pool->done);
+    }
+}
+
+/**
+ * stop the threads started so far and free the pool
+ * @param pool the pool
+ * @param started number of threads started, with the caller of runPool
+ */
+static void freePool(Pool *pool, int started)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < started; ++i)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_barrier_destroy(&pool->barrier);
+    pthread_barrier_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    free(pool->threads);
+    free(pool->args);
+    free(pool);
+}
+
+/**
+ * start a pool, or keep it if it already has this number of workers (the caller of runPool is one of them)
+ * @param pool the pool, NULL until the first call and then set to the pool started
+ * @param workers number of workers
+ * @return 0 if it's work and 1 if not (the pool is then NULL)
+ */
+int startPool(Pool **pool, int workers)
+{
+    if (*pool != NULL && (*pool)->workers == workers)
+    {
+        return 0;
+    }
+    stopPool(pool);
+    if (workers < 1)
+    {
+        return 1;
+    }
+    Pool *started = (Pool *) calloc(1, sizeof(Pool));
+    if (started == NULL)
+    {
+        return 1;
+    }
+    started->threads = (pthread_t *) malloc(sizeof(pthread_t) * (size_t) workers);
+    started->args = (PoolWorker *) malloc(sizeof(PoolWorker) * (size_t) workers);
+    if (started->threads == NULL || started->args == NULL)
+    {
+        free(started->threads);
+        free(started->args);
+        free(started);
+        return 1;
+    }
+    pthread_barrier_init(&started->barrier, NULL, (unsigned) workers);
+    pthread_barrier_init(&started->done, NULL, (unsigned) workers);
+    pthread_mutex_init(&started->lock, NULL);
+    pthread_cond_init(&started->wake, NULL);
+    started->workers = workers;
+    for (int i = 1; i < workers; ++i)
+    {
+        started->args[i].pool = started;
+        started->args[i].worker = i;
+        if (pthread_create(&started->threads[i], NULL, workerMain, &started->args[i]) != 0)
+        {
+            freePool(started, i);
+            return 1;
+        }
+    }
+    *pool = started;
+    return 0;
+}
+
+/**
+ * run a task on all the workers of the pool and wait until all of them are done
+ * @param pool the pool
+ * @param task the task
+ * @param arg argument of the task
+ */
+void runPool(Pool *pool, PoolTask task, void *arg)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(arg, 0, pool->workers);
+    pthread_barrier_wait(&pool->done);
+}
+
+/**
+ * wait until all the workers running the task reach this point
+ * @param pool the pool running the task
+ */
+void poolBarrier(Pool *pool)
+{
+    pthread_barrier_wait(&pool->barrier);
+}
+
+/**
+ * stop the workers of a pool and free it
+ * @param pool the pool, set to NULL (nothing is done if it's already NULL)
+ */
+void stopPool(Pool **pool)
+{
+    if (*pool == NULL)
+    {
+        return;
+    }
+    freePool(*pool, (*pool)->workers);
+    *pool = NULL;
+}
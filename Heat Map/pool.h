@@ -0,0 +1,54 @@
+/**
+ * @file pool.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief pool of worker threads kept alive between the calls of the calculator
+ */
+#ifndef POOL_H
+#define POOL_H
+
+/**
+ * A pool of threads, defined in pool.c. Each owner (a workspace, a batch) has its own, so pools don't wait for each
+ * other; a pool runs one task at a time.
+ */
+typedef struct Pool Pool;
+
+/**
+ * a task run by every worker of the pool at the same time
+ * @param arg the argument given to runPool
+ * @param worker the number of the worker, 0 is the thread which called runPool
+ * @param workers number of workers
+ */
+typedef void (*PoolTask)(void *arg, int worker, int workers);
+
+// ------------------------------ functions -------------------------------
+/**
+ * start a pool, or keep it if it already has this number of workers (the caller of runPool is one of them)
+ * @param pool the pool, NULL until the first call and then set to the pool started
+ * @param workers number of workers
+ * @return 0 if it's work and 1 if not (the pool is then NULL)
+ */
+int startPool(Pool **pool, int workers);
+
+/**
+ * run a task on all the workers of the pool and wait until all of them are done
+ * @param pool the pool
+ * @param task the task
+ * @param arg argument of the task
+ */
+void runPool(Pool *pool, PoolTask task, void *arg);
+
+/**
+ * wait until all the workers running the task reach this point
+ * @param pool the pool running the task
+ */
+void poolBarrier(Pool *pool);
+
+/**
+ * stop the workers of a pool and free it
+ * @param pool the pool, set to NULL (nothing is done if it's already NULL)
+ */
+void stopPool(Pool **pool);
+
+#endif //POOL_H
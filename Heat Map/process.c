@@ -0,0 +1,477 @@
+/**
+ * @file process.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief red-black sweeps split in bands of rows between worker processes, exchanging their edges in shared memory
+ */
+#define _GNU_SOURCE
+
+// ------------------------------ includes --------------------------------
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "profile.h"
+#include "sum.h"
+#include "sweep.h"
+
+// -------------------------- const definitions -------------------------
+#define NODE_CPULIST "/sys/devices/system/node/node%d/cpulist"
+#define SHM_NAME "/heat-map-%ld"
+#define MAX_PATH 64
+#define MAX_CPULIST 4096
+#define SHARED_ALIGNMENT 64
+#define WAIT_POLL_NS 1000000L
+
+/**
+ * The shared memory of a call, mapped by the parent before the fork: the barrier of the workers, the sums of the
+ * bands, the first and last rows of each band (edges[2w] and edges[2w + 1], m points each), the sums of the rows if the
+ * sweep has rowSums (NULL otherwise) and the bands the workers sweep, each one with its ghost layer (see bandBytes).
+ * The parent copies the bands to the grid when the workers are done. Worker 0 adds up the sums of the bands in their
+ * order, or the sums of the rows pairwise, and decides if there is another sweep, like in parallel.c.
+ */
+typedef struct ProcessShared
+{
+    pthread_barrier_t barrier;
+    double delta;
+    unsigned long sweeps;
+    int done;
+    double *bandSum;
+    double *edges;
+    double *rowSums;
+    char *bands;
+} ProcessShared;
+
+// ------------------------------ functions -------------------------------
+/**
+ * count the NUMA nodes of the machine
+ * @return the number of nodes, 1 if the machine doesn't tell
+ */
+static int countNodes(void)
+{
+    char path[MAX_PATH];
+    int nodes = 0;
+    for (;; ++nodes)
+    {
+        snprintf(path, sizeof(path), NODE_CPULIST, nodes);
+        if (access(path, R_OK) != 0)
+        {
+            break;
+        }
+    }
+    return nodes > 0 ? nodes : 1;
+}
+
+/**
+ * pin the calling process to the cpus of a NUMA node, so the band it allocates after is in the memory of the node
+ * @param node the node
+ */
+static void pinToNode(int node)
+{
+    char path[MAX_PATH], list[MAX_CPULIST];
+    cpu_set_t cpus;
+    snprintf(path, sizeof(path), NODE_CPULIST, node);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        return;
+    }
+    int read = fgets(list, sizeof(list), fp) != NULL;
+    fclose(fp);
+    if (!read)
+    {
+        return;
+    }
+    CPU_ZERO(&cpus);
+    for (char *range = list; *range != '\0' && *range != '\n';)
+    { // a list like 0-3,8-11
+        char *end;
+        long first = strtol(range, &end, 10), last = first;
+        if (end == range)
+        {
+            return;
+        }
+        if (*end == '-')
+        {
+            range = end + 1;
+            last = strtol(range, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+        {
+            CPU_SET((int) cpu, &cpus);
+        }
+        range = *end == ',' ? end + 1 : end;
+    }
+    if (CPU_COUNT(&cpus) > 0)
+    {
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+    }
+}
+
+/**
+ * round a size up to the alignment of the parts of the shared memory
+ * @param size the size
+ * @return the rounded size
+ */
+static size_t alignShared(size_t size)
+{
+    return (size + SHARED_ALIGNMENT - 1) / SHARED_ALIGNMENT * SHARED_ALIGNMENT;
+}
+
+/**
+ * the size of the shared memory of a band: its rows and columns with a ghost layer around them, m + 2 points per row
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param worker the number of the worker of the band
+ * @param workers number of workers
+ * @return the size in bytes, rounded up to the alignment of the parts of the shared memory
+ */
+static size_t bandBytes(size_t n, size_t m, int worker, int workers)
+{
+    size_t from = n * (size_t) worker / (size_t) workers, to = n * ((size_t) worker + 1) / (size_t) workers;
+    return alignShared(sizeof(double) * (to - from + 2) * (m + 2));
+}
+
+/**
+ * make the band of a worker a grid over its part of the shared memory, which is 0 until it is written
+ * @param shared the shared memory
+ * @param band set to the band
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param worker the number of the worker
+ * @param workers number of workers
+ */
+static void sharedBand(const ProcessShared *shared, Grid *band, size_t n, size_t m, int worker, int workers)
+{
+    char *block = shared->bands;
+    for (int i = 0; i < worker; ++i)
+    {
+        block += bandBytes(n, m, i, workers);
+    }
+    memset(band, 0, sizeof(Grid));
+    band->block = (double *) block;
+    band->n = n * ((size_t) worker + 1) / (size_t) workers - n * (size_t) worker / (size_t) workers;
+    band->m = m;
+    band->stride = m + 2;
+    band->halo = 1;
+    band->data = band->block + band->stride + 1;
+    band->fd = -1;
+}
+
+/**
+ * map the shared memory of a call, with a name removed right away so it goes with the last process
+ * @param size the size
+ * @return the memory, NULL if it can't be mapped
+ */
+static void *mapShared(size_t size)
+{
+    char name[MAX_PATH];
+    snprintf(name, sizeof(name), SHM_NAME, (long) getpid());
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    shm_unlink(name);
+    void *memory = ftruncate(fd, (off_t) size) == 0 ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                                    : MAP_FAILED;
+    close(fd);
+    return memory == MAP_FAILED ? NULL : memory;
+}
+
+/**
+ * publish the first and last rows of a band, then read the rows around it from its neighbours into its ghost layer
+ * Without cyclic edges the rows around the first and last bands stay 0. The columns of the ghost layer are filled
+ * from the band itself.
+ * @param shared the shared memory
+ * @param band the band, with a ghost layer
+ * @param worker the number of the worker
+ * @param workers number of workers
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ */
+static void exchangeEdges(ProcessShared *shared, Grid *band, int worker, int workers, int is_cyclic)
+{
+    size_t m = band->m, bytes = sizeof(double) * m;
+    ptrdiff_t rows = (ptrdiff_t) band->n;
+    int previous = worker > 0 ? worker - 1 : (is_cyclic ? workers - 1 : -1);
+    int next = worker < workers - 1 ? worker + 1 : (is_cyclic ? 0 : -1);
+
+    pthread_barrier_wait(&shared->barrier); // the neighbours have read the edges of the last exchange
+    memcpy(shared->edges + 2 * (size_t) worker * m, GRID_ROW(band, 0), bytes);
+    memcpy(shared->edges + (2 * (size_t) worker + 1) * m, GRID_ROW(band, rows - 1), bytes);
+    pthread_barrier_wait(&shared->barrier);
+    if (previous >= 0)
+    {
+        memcpy(GRID_ROW(band, -1), shared->edges + (2 * (size_t) previous + 1) * m, bytes);
+    }
+    if (next >= 0)
+    {
+        memcpy(GRID_ROW(band, rows), shared->edges + 2 * (size_t) next * m, bytes);
+    }
+    if (is_cyclic)
+    {
+        for (ptrdiff_t x = -1; x <= rows; ++x)
+        {
+            GRID_AT(band, x, -1) = GRID_AT(band, x, (ptrdiff_t) m - 1);
+            GRID_AT(band, x, (ptrdiff_t) m) = GRID_AT(band, x, 0);
+        }
+    }
+}
+
+/**
+ * body of a worker process: copy its band of the grid to the shared memory and sweep it until the solve is done
+ * @param state the sweep of the call
+ * @param shared the shared memory
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param worker the number of the worker
+ * @param workers number of workers
+ * @return 0 if it's work and 1 if not
+ */
+static int solveProcess(const SweepState *state, ProcessShared *shared, const source_point *sources,
+                        size_t num_sources, double terminate, unsigned int n_iter, int worker, int workers)
+{
+    const Grid *grid = state->grid;
+    size_t n = grid->n, m = grid->m, count = 0;
+    size_t from = n * (size_t) worker / (size_t) workers, to = n * ((size_t) worker + 1) / (size_t) workers;
+    SweepState local = *state;
+    Grid band;
+    double sum = 0, previousSum = 0;
+    ProfileMark mark;
+
+    pinToNode(worker % countNodes());
+    source_point *bandSources = (source_point *) malloc(sizeof(source_point) * (num_sources + 1));
+    if (bandSources == NULL)
+    {
+        return 1;
+    }
+    sharedBand(shared, &band, n, m, worker, workers);
+    for (size_t i = 0; i < num_sources; ++i)
+    { // the sources of the band, on the rows of the band
+        if (sources[i].x >= (int) from && sources[i].x < (int) to)
+        {
+            bandSources[count] = sources[i];
+            bandSources[count++].x -= (int) from;
+        }
+    }
+    local.grid = &band;
+    local.firstRow = from;
+    local.rowSums = shared->rowSums;
+    if (buildSourceIndex(&local.index, bandSources, count, to - from, m, SOURCES_BY_ROW))
+    {
+        return 1;
+    }
+    for (size_t x = from; x < to; ++x)
+    {
+        memcpy(GRID_ROW(&band, x - from), GRID_ROW(grid, x), sizeof(double) * m);
+    }
+    while (!shared->done)
+    {
+        if (worker == 0 && profileLevel)
+        { // the sweep starts when the workers leave the barrier of the last one
+            profileMark(&mark);
+        }
+        exchangeEdges(shared, &band, worker, workers, state->is_cyclic);
+        redBlackPass(&local, RED, 0, (int) (to - from));
+        exchangeEdges(shared, &band, worker, workers, state->is_cyclic);
+        shared->bandSum[worker] = redBlackPass(&local, BLACK, 0, (int) (to - from));
+        pthread_barrier_wait(&shared->barrier);
+        if (worker == 0)
+        {
+            previousSum = sum;
+            sum = 0;
+            if (shared->rowSums != NULL)
+            { // the same sum for any number of workers
+                sum = pairwiseSum(shared->rowSums, n);
+            }
+            for (int i = 0; i < workers && shared->rowSums == NULL; ++i)
+            {
+                sum += shared->bandSum[i];
+            }
+            shared->delta = sum - previousSum;
+            ++shared->sweeps;
+            if (profileLevel)
+            { // the times stay in this process, the trace is written to the stderr of the program
+                profileSweep(&mark, shared->delta);
+            }
+            if (n_iter > 0)
+            {
+                shared->done = shared->sweeps >= n_iter;
+            }
+            else
+            {
+                shared->done = !(shared->delta > terminate || -shared->delta > terminate);
+            }
+        }
+        pthread_barrier_wait(&shared->barrier);
+    }
+    return 0;
+}
+
+/**
+ * wait for the workers, and kill the others as soon as one fails (they would wait for it at the barrier)
+ * Only the workers are waited for, by their pid: the other children of the program are left to it. As any worker can
+ * fail first, they are polled until one fails, then the ones killed are waited for.
+ * @param pids the workers, each one set to 0 when it is waited for
+ * @param workers number of workers
+ * @return 0 if they all worked and 1 if not
+ */
+static int waitWorkers(pid_t *pids, int workers)
+{
+    const struct timespec poll = {0, WAIT_POLL_NS};
+    int failed = 0;
+    for (int left = workers; left > 0;)
+    {
+        int waited = 0;
+        for (int i = 0; i < workers; ++i)
+        {
+            int status;
+            pid_t pid = pids[i] > 0 ? waitpid(pids[i], &status, failed ? 0 : WNOHANG) : 0;
+            if (pid == 0 || (pid < 0 && errno == EINTR))
+            {
+                continue;
+            }
+            pids[i] = 0;
+            --left;
+            waited = 1;
+            if (!failed && (pid < 0 || !(WIFEXITED(status) && WEXITSTATUS(status) == 0)))
+            {
+                failed = 1;
+                for (int j = 0; j < workers; ++j)
+                {
+                    if (pids[j] > 0)
+                    {
+                        kill(pids[j], SIGKILL);
+                    }
+                }
+            }
+        }
+        if (!waited && !failed)
+        {
+            nanosleep(&poll, NULL);
+        }
+    }
+    return failed;
+}
+
+/**
+ * calculate the grid with a red-black sweep split in bands of rows between worker processes, until n_iter sweeps are
+ * done or the difference between the sums of two sweeps is below terminate (if n_iter is 0).
+ * Each worker is pinned to a NUMA node (round robin) before it copies its band, so the band is in the memory of its
+ * node. The workers exchange the edges of their bands in shared memory twice per sweep, the last band with the first
+ * one when the grid is cyclic, and add up their sums in the order of the bands: the grid and the sums are the same
+ * as with calculateParallel. The workers are forked for each call; the grid is only changed if they all worked.
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param processes number of workers, 0 for one per NUMA node
+ * @param delta set to the difference between the sums of the two last sweeps
+ * @param sweeps set to the number of sweeps done
+ * @return 0 if it's work and 1 if the workers can't be started or failed
+ */
+int calculateProcesses(SweepState *state, const source_point *sources, size_t num_sources, double terminate,
+                       unsigned int n_iter, int processes, double *delta, unsigned long *sweeps)
+{
+    Grid *grid = state->grid;
+    size_t n = grid->n, m = grid->m;
+    int workers = processes > 0 ? processes : countNodes();
+    workers = (size_t) workers > n ? (int) n : workers;
+    if (workers < 2 || m == 0)
+    {
+        return 1;
+    }
+    size_t header = alignShared(sizeof(ProcessShared)), sums = alignShared(sizeof(double) * (size_t) workers);
+    size_t edges = alignShared(sizeof(double) * 2 * (size_t) workers * m);
+    size_t rows = state->rowSums != NULL ? alignShared(sizeof(double) * n) : 0, size = header + sums + edges + rows;
+    for (int i = 0; i < workers; ++i)
+    {
+        size += bandBytes(n, m, i, workers);
+    }
+    char *memory = (char *) mapShared(size);
+    pid_t *pids = (pid_t *) calloc((size_t) workers, sizeof(pid_t));
+    if (memory == NULL || pids == NULL)
+    {
+        free(pids);
+        if (memory != NULL)
+        {
+            munmap(memory, size);
+        }
+        return 1;
+    }
+    ProcessShared *shared = (ProcessShared *) memory;
+    shared->delta = 0;
+    shared->sweeps = 0;
+    shared->done = 0;
+    shared->bandSum = (double *) (memory + header);
+    shared->edges = (double *) (memory + header + sums);
+    shared->rowSums = state->rowSums != NULL ? (double *) (memory + header + sums + edges) : NULL;
+    shared->bands = memory + header + sums + edges + rows;
+    pthread_barrierattr_t attributes;
+    pthread_barrierattr_init(&attributes);
+    pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    int failed = pthread_barrier_init(&shared->barrier, &attributes, (unsigned int) workers) != 0;
+    pthread_barrierattr_destroy(&attributes);
+
+    int started = 0;
+    for (; !failed && started < workers; ++started)
+    {
+        pids[started] = fork();
+        if (pids[started] == 0)
+        {
+            _exit(solveProcess(state, shared, sources, num_sources, terminate, n_iter, started, workers));
+        }
+        if (pids[started] < 0)
+        {
+            failed = 1;
+            for (int i = 0; i < started; ++i)
+            {
+                kill(pids[i], SIGKILL);
+            }
+        }
+    }
+    if (failed)
+    {
+        for (int i = 0; i + 1 < started; ++i)
+        { // the last one could not be forked
+            waitpid(pids[i], NULL, 0);
+        }
+    }
+    else
+    {
+        failed = waitWorkers(pids, workers);
+    }
+    for (int i = 0; !failed && i < workers; ++i)
+    {
+        Grid band;
+        sharedBand(shared, &band, n, m, i, workers);
+        for (size_t x = 0; x < band.n; ++x)
+        {
+            memcpy(GRID_ROW(grid, n * (size_t) i / (size_t) workers + x), GRID_ROW(&band, x), sizeof(double) * m);
+        }
+    }
+    if (!failed)
+    {
+        *delta = shared->delta;
+        *sweeps = shared->sweeps;
+    }
+    if (!failed)
+    { // a killed worker can be left in the barrier, destroying it would wait for it
+        pthread_barrier_destroy(&shared->barrier);
+    }
+    munmap(memory, size);
+    free(pids);
+    return failed;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file profile.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief opt-in timings of the phases of a run, printed on stderr when the program exits
+ */
+#define _POSIX_C_SOURCE 200112L
+
+// ------------------------------ includes --------------------------------
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "profile.h"
+
+// -------------------------- const definitions -------------------------
+#define PROFILE_PREFIX "profile: "
+
+/**
+ * the times added to a phase, in seconds
+ */
+typedef struct PhaseTimes
+{
+    unsigned long count;
+    double wall;
+    double cpu;
+    double maxWall;
+} PhaseTimes;
+
+static const char *const PHASE_NAMES[NUM_PHASES] = {"parse", "calculate", "sweep", "print"};
+
+int profileLevel = PROFILE_NONE;
+static PhaseTimes phases[NUM_PHASES];
+static unsigned long totalSweeps = 0;
+static double lastDelta = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// ------------------------------ functions -------------------------------
+/**
+ * read a clock
+ * @param clock the clock
+ * @return the time in seconds
+ */
+static double readClock(clockid_t clock)
+{
+    struct timespec time;
+    clock_gettime(clock, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+}
+
+/**
+ * add a time to a phase
+ * @param phase the phase
+ * @param wall the wall time
+ * @param cpu the cpu time
+ */
+static void addTimes(PhaseTimes *phase, double wall, double cpu)
+{
+    pthread_mutex_lock(&lock); // the batch workers add their phases at the same time
+    ++phase->count;
+    phase->wall += wall;
+    phase->cpu += cpu;
+    if (wall > phase->maxWall)
+    {
+        phase->maxWall = wall;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * print the summary on stderr, called when the program exits
+ */
+static void printSummary(void)
+{
+    fprintf(stderr, PROFILE_PREFIX "%-10s %10s %14s %14s %14s\n", "phase", "count", "wall (s)", "cpu (s)",
+            "max wall (s)");
+    for (int i = 0; i < NUM_PHASES; ++i)
+    {
+        fprintf(stderr, PROFILE_PREFIX "%-10s %10lu %14.6f %14.6f %14.6f\n", PHASE_NAMES[i], phases[i].count,
+                phases[i].wall, phases[i].cpu, phases[i].maxWall);
+    }
+    fprintf(stderr, PROFILE_PREFIX "%lu sweeps in %lu calls, %lu timed one by one, last delta %.9g\n", totalSweeps,
+            phases[PHASE_CALCULATE].count, phases[PHASE_SWEEP].count, lastDelta);
+}
+
+/**
+ * start the profile
+ * @param level PROFILE_NONE, PROFILE_SUMMARY or PROFILE_TRACE
+ */
+void initProfile(int level)
+{
+    if (level != PROFILE_NONE && profileLevel == PROFILE_NONE)
+    {
+        atexit(printSummary);
+    }
+    if (level != PROFILE_NONE || profileLevel == PROFILE_NONE)
+    {
+        profileLevel = level;
+    }
+}
+
+/**
+ * read the clocks at the start of a phase
+ * @param mark set to the clocks
+ */
+void profileMark(ProfileMark *mark)
+{
+    mark->wall = readClock(CLOCK_MONOTONIC);
+    mark->cpu = readClock(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+/**
+ * add the time since mark to a phase
+ * @param phase PHASE_PARSE, PHASE_CALCULATE or PHASE_PRINT
+ * @param mark the clocks at the start of the phase
+ */
+void profilePhase(int phase, const ProfileMark *mark)
+{
+    ProfileMark now;
+    profileMark(&now);
+    addTimes(&phases[phase], now.wall - mark->wall, now.cpu - mark->cpu);
+}
+
+/**
+ * add a sweep timed on its own
+ * @param mark the clocks at the start of the sweep
+ * @param delta the difference between the sums of the sweep and of the one before
+ */
+void profileSweep(const ProfileMark *mark, double delta)
+{
+    ProfileMark now;
+    profileMark(&now);
+    double wall = now.wall - mark->wall, cpu = now.cpu - mark->cpu;
+    addTimes(&phases[PHASE_SWEEP], wall, cpu);
+    if (profileLevel == PROFILE_TRACE)
+    {
+        fprintf(stderr, PROFILE_PREFIX "sweep %lu delta %.9g wall %.9f cpu %.9f\n", phases[PHASE_SWEEP].count, delta,
+                wall, cpu);
+    }
+}
+
+/**
+ * trace sweeps timed together
+ * @param mark the clocks at the start of the sweeps
+ * @param sweeps number of sweeps
+ * @param delta the difference between the sums of the last sweep and of the one before
+ */
+void profileSweepBlock(const ProfileMark *mark, unsigned long sweeps, double delta)
+{
+    if (profileLevel == PROFILE_TRACE)
+    {
+        ProfileMark now;
+        profileMark(&now);
+        fprintf(stderr, PROFILE_PREFIX "%lu sweeps delta %.9g wall %.9f cpu %.9f\n", sweeps, delta,
+                now.wall - mark->wall, now.cpu - mark->cpu);
+    }
+}
+
+/**
+ * add the sweeps of a calculate call
+ * @param sweeps number of sweeps
+ * @param delta the delta returned by the call
+ */
+void profileSweeps(unsigned long sweeps, double delta)
+{
+    pthread_mutex_lock(&lock);
+    totalSweeps += sweeps;
+    lastDelta = delta;
+    pthread_mutex_unlock(&lock);
+}
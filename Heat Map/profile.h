@@ -0,0 +1,86 @@
+/**
+ * @file profile.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief opt-in timings of the phases of a run (the profile option, HEAT_PROFILE)
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// -------------------------- const definitions -------------------------
+#define PROFILE_NONE 0
+#define PROFILE_SUMMARY 1
+#define PROFILE_TRACE 2
+
+#define PHASE_PARSE 0
+#define PHASE_CALCULATE 1
+#define PHASE_SWEEP 2
+#define PHASE_PRINT 3
+#define NUM_PHASES 4
+
+/**
+ * the wall and cpu clocks when a phase started, in seconds
+ */
+typedef struct ProfileMark
+{
+    double wall;
+    double cpu;
+} ProfileMark;
+
+/**
+ * PROFILE_NONE, or the level given to initProfile. The hooks are called only if it is not PROFILE_NONE, so a run
+ * without profile only pays for this test:
+ *     ProfileMark mark;
+ *     if (profileLevel) profileMark(&mark);
+ *     ... the phase ...
+ *     if (profileLevel) profilePhase(PHASE_PRINT, &mark);
+ */
+extern int profileLevel;
+
+// ------------------------------ functions -------------------------------
+/**
+ * start the profile. PROFILE_SUMMARY prints the time of each phase and the sweeps on stderr when the program exits,
+ * PROFILE_TRACE also prints a line per sweep with its delta and its time as the sweeps are done (per block or per
+ * cycle for the sweeps timed together).
+ * @param level PROFILE_NONE, PROFILE_SUMMARY or PROFILE_TRACE
+ */
+void initProfile(int level);
+
+/**
+ * read the clocks at the start of a phase
+ * @param mark set to the clocks
+ */
+void profileMark(ProfileMark *mark);
+
+/**
+ * add the time since mark to a phase
+ * @param phase PHASE_PARSE, PHASE_CALCULATE or PHASE_PRINT
+ * @param mark the clocks at the start of the phase
+ */
+void profilePhase(int phase, const ProfileMark *mark);
+
+/**
+ * add a sweep timed on its own
+ * @param mark the clocks at the start of the sweep
+ * @param delta the difference between the sums of the sweep and of the one before
+ */
+void profileSweep(const ProfileMark *mark, double delta);
+
+/**
+ * trace sweeps timed together, a temporal block or a multigrid cycle: they are only counted by profileSweeps
+ * @param mark the clocks at the start of the sweeps
+ * @param sweeps number of sweeps
+ * @param delta the difference between the sums of the last sweep and of the one before
+ */
+void profileSweepBlock(const ProfileMark *mark, unsigned long sweeps, double delta);
+
+/**
+ * add the sweeps of a calculate call, timed one by one or not (the temporal blocks and the multigrid cycles only
+ * count as a whole in the call, and the processes time their sweeps in worker 0)
+ * @param sweeps number of sweeps
+ * @param delta the delta returned by the call
+ */
+void profileSweeps(unsigned long sweeps, double delta);
+
+#endif //PROFILE_H
@@ -8,52 +8,37 @@
 #define _GNU_SOURCE
 
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <stdlib.h>
 #include <string.h>
-#include "calculator.h"
-#include "heat_eqn.h"
+#include <unistd.h>
+#include "profile.h"
+#include "reader.h"
+#include "scan.h"
+#include "status.h"
 
 // ------------------------------ includes --------------------------------
 
 #define INIT_SIZE 2
 #define REALLOC_FACTOR 2
-#define ERROR_MEMORY "Memory allocation failed."
 #define SEPARATOR "----\n"
-#define ERROR_SIZE "Error with file format: grid size."
-#define ERROR_TERMINATE "Error with file format: termination value."
-#define ERROR_N_ITER "Error with file format: n_iter."
-#define ERROR_CYCLIC "Error with file format: is_cyclic."
-#define ERROR_SOURCE "Error with file format: source point."
-#define ERROR_OUT_OF_RANGE "Segmentation fault"
+#define DELTA_PRECISION 6
+#define CELL_PRECISION 4
 
 // ------------------------------ functions -------------------------------
-/**
- * free the grid list of list
- * @param grid the grid
- * @param n number of list
- */
-void freeGrid(double ***grid, int n)
-{
-    for (int i = 0; i < n; ++i)
-    {
-        free((*grid)[i]);
-    }
-    free(*grid);
-}
-
 /**
  * free memory, close the file and exit
  * @param line input line
  * @param grid the grid
- * @param n width
  * @param listSources list of heat source
  * @param fp file
  */
-void closeAndFree(char *line, double ***grid, int n, source_point *listSources, FILE *fp)
+void closeAndFree(char *line, Grid *grid, source_point *listSources, FILE *fp)
 {
     if (grid != NULL)
     {
-        freeGrid(grid, n);
+        freeGrid(grid);
     }
     if (line != NULL)
     {
@@ -71,87 +56,245 @@ void closeAndFree(char *line, double ***grid, int n, source_point *listSources,
 }
 
 /**
- * initialization of the grid with 0 on each coordinate
- * @param grid pointer of pointer of value (double) of temperature
- * @param n width of the grid
- * @param m length of the grid
- * @return the grid
+ * read the next line of the input into its line buffer, an empty line at the end of the file
+ * @param fp the file
+ * @param input the input
+ * @return 0 if it's work and 1 if there is not enough memory
  */
-int initGrid(double ***grid, int n, int m)
+static int readLine(FILE *fp, HeatInput *input)
 {
-    *grid = (double **) malloc(sizeof(double *) * n);
-    if (*grid == NULL)
+    if (getline(&input->line, &input->lineSize, fp) < 0)
     {
-        free(*grid);
-        return 1;
-    }
-    for (int i = 0; i < n; ++i)
-    {
-        (*grid)[i] = (double *) calloc((size_t) m, sizeof(double));
-        if ((*grid)[i] == NULL)
+        if (input->line == NULL)
         {
-            freeGrid(grid, i);
             return 1;
         }
+        input->line[0] = '\0';
     }
     return 0;
 }
 
 /**
- * Parse the source file
- * @param line input line
- * @param fp the file
- * @param n width
- * @param m length
- * @param grid the grid
- * @param listSources list of source
- * @param numSource number od sources
- * @param initSize
+ * make room for a number of sources in the input
+ * @param input the input
+ * @param count number of sources
  * @return 0 if it's work and 1 if not
  */
-int findSources(char *line, FILE *fp, int n, int m, double ***grid, source_point **listSources, int *numSource,
-                int initSize)
+static int reserveSources(HeatInput *input, size_t count)
+{
+    if (count <= input->sourceCapacity)
+    {
+        return 0;
+    }
+    source_point *grown = (source_point *) realloc(input->sources, sizeof(source_point) * count);
+    if (grown == NULL)
+    {
+        return 1;
+    }
+    input->sources = grown;
+    input->sourceCapacity = count;
+    return 0;
+}
+
+/**
+ * Parse the source lines up to the separator
+ * @param fp the file
+ * @param input the input, with its size
+ * @return HEAT_OK or the error
+ */
+static int findSources(FILE *fp, HeatInput *input)
 {
     int x, y;
     double value;
-    size_t len = 0;
 
-    getline(&line, &len, fp);
-    while (strcmp(SEPARATOR, line) != 0)
+    if (readLine(fp, input))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    while (strcmp(SEPARATOR, input->line) != 0)
     {
-        if (sscanf(line, "%d, %d, %lf", &x, &y, &value) != 3)
+        if (sscanf(input->line, "%d, %d, %lf", &x, &y, &value) != 3)
         {
-            fprintf(stderr, ERROR_SOURCE);
-            free(line);
-            return 1;
+            return HEAT_ERROR_SOURCE;
         }
-        if (x >= n || y >= m)
+        if (x < 0 || y < 0 || x >= input->n || y >= input->m)
         { // check bad input
-            fprintf(stderr, ERROR_OUT_OF_RANGE);
-            free(line);
-            return 1;
+            return HEAT_ERROR_OUT_OF_RANGE;
+        }
+        if ((size_t) input->numSources >= input->sourceCapacity &&
+            reserveSources(input, input->sourceCapacity * REALLOC_FACTOR))
+        {
+            return HEAT_ERROR_MEMORY;
         }
+        input->sources[input->numSources].x = x;
+        input->sources[input->numSources].y = y;
+        input->sources[input->numSources].value = value;
+        input->numSources++;
+        if (readLine(fp, input))
+        {
+            return HEAT_ERROR_MEMORY;
+        }
+    }
+    return HEAT_OK;
+}
+
+/**
+ * Parse the sources from the file mapped in memory, from the current position of fp up to the separator
+ * The sources are counted first so the list is allocated once, and each line is read by scanSourceLine. fp is moved
+ * after the separator. A file which can't be mapped (a pipe, a buffer) is left to findSources.
+ * @param fp the file, after the separator before the sources
+ * @param input the input, with its size
+ * @return HEAT_OK, the error, or -1 if the file can't be mapped
+ */
+static int findSourcesMapped(FILE *fp, HeatInput *input)
+{
+    struct stat status;
+    long offset = ftell(fp);
+    if (offset < 0 || fileno(fp) < 0 || fstat(fileno(fp), &status) != 0 || !S_ISREG(status.st_mode) ||
+        status.st_size <= offset)
+    {
+        return -1;
+    }
+    size_t size = (size_t) status.st_size;
+    char *map = (char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if (map == MAP_FAILED)
+    {
+        return -1;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    const char *begin = map + offset, *end = map + size, *line = begin, *next;
+    size_t count = 0, separator = strlen(SEPARATOR);
+    int error = HEAT_OK;
 
-        if (*numSource >= initSize)
+    for (; line < end; line = next, ++count)
+    { // count the sources
+        const char *newline = (const char *) memchr(line, '\n', (size_t) (end - line));
+        next = newline == NULL ? end : newline + 1;
+        if ((size_t) (next - line) == separator && memcmp(line, SEPARATOR, separator) == 0)
         {
-            initSize *= REALLOC_FACTOR;
-            *listSources = (source_point *) realloc(*listSources, sizeof(source_point) * initSize);
+            break;
         }
-        (*listSources)[*numSource].x = x;
-        (*listSources)[*numSource].y = y;
-        (*listSources)[*numSource].value = value;
-        (*grid)[x][y] = value;
-        *numSource = *numSource + 1;
-        getline(&line, &len, fp);
-    }
-    free(line);
-    return 0;
+    }
+    if (reserveSources(input, count + 1))
+    {
+        munmap(map, size);
+        return HEAT_ERROR_MEMORY;
+    }
+    line = begin;
+    size_t stored = 0;
+    for (; stored < count; ++stored, line = next)
+    {
+        int x, y;
+        double value;
+        const char *newline = (const char *) memchr(line, '\n', (size_t) (end - line));
+        next = newline == NULL ? end : newline + 1;
+        if (scanSourceLine(line, next, &x, &y, &value))
+        {
+            error = HEAT_ERROR_SOURCE;
+            break;
+        }
+        if (x < 0 || y < 0 || x >= input->n || y >= input->m)
+        { // check bad input
+            error = HEAT_ERROR_OUT_OF_RANGE;
+            break;
+        }
+        input->sources[stored].x = x;
+        input->sources[stored].y = y;
+        input->sources[stored].value = value;
+    }
+    input->numSources = (int) stored;
+    munmap(map, size);
+    if (error == HEAT_OK && line == end)
+    { // no separator after the sources
+        error = HEAT_ERROR_SOURCE;
+    }
+    if (error == HEAT_OK && fseek(fp, offset + (long) (line - begin) + (long) separator, SEEK_SET) != 0)
+    {
+        error = HEAT_ERROR_FILE;
+    }
+    return error;
 }
 
 /**
- * Parse the file
+ * Parse an input, without exiting on an error
+ * @param fp the file
+ * @param input the input, its sources and line buffers reused if they are large enough
+ * @return HEAT_OK or the error
+ */
+int readInput(FILE *fp, HeatInput *input)
+{
+    int iter, error;
+    input->numSources = 0;
+    if (readLine(fp, input)) // get size of the board
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    if (sscanf(input->line, "%d, %d", &input->n, &input->m) != 2 || input->n < 0 || input->m < 0)
+    {
+        return HEAT_ERROR_SIZE;
+    }
+    if (readLine(fp, input) || reserveSources(input, INIT_SIZE))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    if (strcmp(SEPARATOR, input->line) == 0)
+    {
+        error = findSourcesMapped(fp, input);
+        if (error < 0)
+        {
+            error = findSources(fp, input);
+        }
+        if (error != HEAT_OK)
+        {
+            return error;
+        }
+    }
+    if (readLine(fp, input))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    if (sscanf(input->line, "%lf\n", &input->terminate) != 1)
+    {
+        return HEAT_ERROR_TERMINATE;
+    }
+    if (readLine(fp, input))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    if (sscanf(input->line, "%d", &iter) != 1 || iter < 0)
+    {
+        return HEAT_ERROR_N_ITER;
+    }
+    input->n_iter = (unsigned int) iter;
+    if (readLine(fp, input))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    if (sscanf(input->line, "%d", &input->is_cyclic) != 1)
+    {
+        return HEAT_ERROR_CYCLIC;
+    }
+    return HEAT_OK;
+}
+
+/**
+ * free the buffers of an input
+ * @param input the input
+ */
+void freeInput(HeatInput *input)
+{
+    free(input->sources);
+    free(input->line);
+    input->sources = NULL;
+    input->line = NULL;
+    input->sourceCapacity = 0;
+    input->lineSize = 0;
+}
+
+/**
+ * Parse the file, the grid is allocated by the caller once the precision is known. The messages of the errors are
+ * printed on stderr and the program exits.
  * @param fp file
- * @param grid the grid
  * @param n width
  * @param m length
  * @param listSources list of sources
@@ -160,128 +303,130 @@ int findSources(char *line, FILE *fp, int n, int m, double ***grid, source_point
  * @param n_iter
  * @param is_cyclic
  */
-void parseFile(FILE *fp, double ***grid, int *n, int *m, source_point **listSources, int *numSource, double *terminate,
+void parseFile(FILE *fp, int *n, int *m, source_point **listSources, int *numSource, double *terminate,
                unsigned int *n_iter, int *is_cyclic)
 {
-    if (fp == NULL)
-    {
-        exit(1);
-    }
-    char *line = NULL;
-    size_t len = 0;
-    getline(&line, &len, fp); // get size of the board
-    int initSize = INIT_SIZE, iter;
-    if (sscanf(line, "%d, %d", n, m) != 2)
+    HeatInput input = {0, 0, NULL, 0, 0, 0, 0, 0, NULL, 0};
+    ProfileMark mark;
+    if (profileLevel)
     {
-        fprintf(stderr, ERROR_SIZE);
-        closeAndFree(line, NULL, *n, NULL, fp);
+        profileMark(&mark);
     }
-    if (*n < 0 || *m < 0)
+    if (fp == NULL)
     {
-        fprintf(stderr, ERROR_SIZE);
-        closeAndFree(line, NULL, *n, NULL, fp);
+        exit(1);
     }
-    if (initGrid(grid, *n, *m))
+    int error = readInput(fp, &input);
+    if (error != HEAT_OK)
     {
-        fprintf(stderr, ERROR_MEMORY);
-        closeAndFree(line, NULL, *n, NULL, fp);
+        fprintf(stderr, "%s", statusMessage(error));
+        free(input.line);
+        closeAndFree(NULL, NULL, input.sources, fp);
     }
-    getline(&line, &len, fp);
-    *listSources = (source_point *) malloc(sizeof(source_point) * initSize);
-    if (*listSources == NULL)
+    free(input.line);
+    *n = input.n;
+    *m = input.m;
+    *listSources = input.sources;
+    *numSource = input.numSources;
+    *terminate = input.terminate;
+    *n_iter = input.n_iter;
+    *is_cyclic = input.is_cyclic;
+    if (profileLevel)
     {
-        fprintf(stderr, ERROR_MEMORY);
-        closeAndFree(line, grid, *n, *listSources, fp);
+        profilePhase(PHASE_PARSE, &mark);
     }
-    if (strcmp(SEPARATOR, line) == 0)
+}
+
+/**
+ * put the sources on a grid
+ * @param grid the grid
+ * @param listSources list of source
+ * @param numSource number of sources
+ */
+void placeSources(Grid *grid, const source_point *listSources, int numSource)
+{
+    for (int i = 0; i < numSource; ++i)
     {
-        if (findSources(line, fp, *n, *m, grid, listSources, numSource, initSize))
-        {
-            closeAndFree(line, grid, *n, *listSources, fp);
-        }
+        GRID_AT(grid, listSources[i].x, listSources[i].y) = listSources[i].value;
     }
-    getline(&line, &len, fp);
+}
 
-    if (sscanf(line, "%lf\n", terminate) != 1)
+/**
+ * print the delta value, as printf("%lf\n") would print its absolute value
+ * @param out the output
+ * @param delta the delta
+ */
+void printDelta(Output *out, double delta)
+{
+    if (delta < 0)
     {
-        fprintf(stderr, ERROR_TERMINATE);
-        closeAndFree(line, grid, *n, *listSources, fp);
-
+        outputFixed(out, -delta, DELTA_PRECISION);
     }
-    getline(&line, &len, fp);
-    if (sscanf(line, "%d", &iter) != 1 || iter < 0)
+    else
     {
-        fprintf(stderr, ERROR_N_ITER);
-        closeAndFree(line, grid, *n, *listSources, fp);
+        outputFixed(out, delta, DELTA_PRECISION);
     }
-    *n_iter = (unsigned int) iter;
-    getline(&line, &len, fp);
-    if (sscanf(line, "%d", is_cyclic) != 1)
-    {
-        fprintf(stderr, ERROR_CYCLIC);
-        closeAndFree(line, grid, *n, *listSources, fp);
-    };
-    free(line);
+    outputChar(out, '\n');
 }
 
 /**
- * print the delta value and the grid
+ * print the delta value and the grid, as printf("%lf\n") and printf("%.4f,") would
+ * @param out the output
  * @param grid the grid
  * @param delta the delta
- * @param n width
- * @param m length
  */
-void printGrid(double **grid, double delta, int n, int m)
+void printGrid(Output *out, const Grid *grid, double delta)
 {
-    if (delta < 0)
-    {
-        printf("%lf\n", -delta);
-    }
-    else
+    ProfileMark mark;
+    if (profileLevel)
     {
-        printf("%lf\n", delta);
+        profileMark(&mark);
     }
-    for (int j = 0; j < n; ++j)
+    printDelta(out, delta);
+    for (size_t j = 0; j < grid->n; ++j)
     {
-        for (int i = 0; i < m; ++i)
+        const double *row = GRID_ROW(grid, j);
+        for (size_t i = 0; i < grid->m; ++i)
         {
-            printf("%.4f,", grid[j][i]);
+            outputFixed(out, row[i], CELL_PRECISION);
+            outputChar(out, ',');
         }
-        printf("\n");
+        outputChar(out, '\n');
+    }
+    flushOutput(out);
+    if (profileLevel)
+    {
+        profilePhase(PHASE_PRINT, &mark);
     }
 }
 
 /**
- * The main function
- * @param argc
- * @param argv
- * @return
+ * print the delta value and a float grid, like printGrid
+ * @param out the output
+ * @param grid the grid
+ * @param delta the delta
  */
-int main(int argc, char *argv[])
+void printFloatGrid(Output *out, const FloatGrid *grid, double delta)
 {
-    FILE *fp;
-    (void) argc;
-    double **grid;
-    source_point *listSources;
-    int n, m, numSource = 0, is_cyclic;
-    double terminate;
-    unsigned int n_iter;
-
-    fp = fopen(argv[1], "r");
-    parseFile(fp, &grid, &n, &m, &listSources, &numSource, &terminate, &n_iter, &is_cyclic);
-    fclose(fp);
-
-    double delta = calculate(heat_eqn, grid, (size_t) n, (size_t) m, listSources, (size_t) numSource, terminate, n_iter,
-                             is_cyclic);
-    printGrid(grid, delta, n, m);
-
-    while (delta > terminate || -delta > terminate)
+    ProfileMark mark;
+    if (profileLevel)
     {
-        delta = calculate(heat_eqn, grid, (size_t) n, (size_t) m, listSources, (size_t) numSource, terminate, n_iter,
-                          is_cyclic);
-        printGrid(grid, delta, n, m);
-
+        profileMark(&mark);
     }
-    closeAndFree(NULL, &grid, n, listSources, NULL);
-    return 0;
-}
\ No newline at end of file
+    printDelta(out, delta);
+    for (size_t j = 0; j < grid->n; ++j)
+    {
+        const float *row = GRID_ROW(grid, j);
+        for (size_t i = 0; i < grid->m; ++i)
+        {
+            outputFixed(out, row[i], CELL_PRECISION);
+            outputChar(out, ',');
+        }
+        outputChar(out, '\n');
+    }
+    flushOutput(out);
+    if (profileLevel)
+    {
+        profilePhase(PHASE_PRINT, &mark);
+    }
+}
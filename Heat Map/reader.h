@@ -0,0 +1,99 @@
+/**
+ * @file reader.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief read the input and print the result
+ */
+#ifndef READER_H
+#define READER_H
+
+// ------------------------------ includes --------------------------------
+#include <stdio.h>
+#include "calculator.h"
+#include "grid.h"
+#include "output.h"
+#include "status.h"
+
+/**
+ * a parsed input, its buffers kept from one input to the next
+ */
+typedef struct HeatInput
+{
+    int n;
+    int m;
+    source_point *sources;
+    int numSources;
+    size_t sourceCapacity;
+    double terminate;
+    unsigned int n_iter;
+    int is_cyclic;
+    char *line;
+    size_t lineSize;
+} HeatInput;
+
+// ------------------------------ functions -------------------------------
+/**
+ * free memory, close the file and exit
+ * @param line input line
+ * @param grid the grid
+ * @param listSources list of heat source
+ * @param fp file
+ */
+void closeAndFree(char *line, Grid *grid, source_point *listSources, FILE *fp);
+
+/**
+ * Parse an input, without exiting on an error. The sources and the line buffers of input are reused if they are large
+ * enough, so parsing inputs of the same kind again allocates nothing. input starts with NULL buffers and 0 capacities.
+ * @param fp the file
+ * @param input the input
+ * @return HEAT_OK or the error, the sources read before it stay in input
+ */
+int readInput(FILE *fp, HeatInput *input);
+
+/**
+ * free the buffers of an input
+ * @param input the input
+ */
+void freeInput(HeatInput *input);
+
+/**
+ * Parse the file, the grid is allocated by the caller once the precision is known. The messages of the errors are
+ * printed on stderr and the program exits.
+ * @param fp file
+ * @param n width
+ * @param m length
+ * @param listSources list of sources
+ * @param numSource number of sources
+ * @param terminate
+ * @param n_iter
+ * @param is_cyclic
+ */
+void parseFile(FILE *fp, int *n, int *m, source_point **listSources, int *numSource, double *terminate,
+               unsigned int *n_iter, int *is_cyclic);
+
+/**
+ * put the sources on a grid
+ * @param grid the grid
+ * @param listSources list of source
+ * @param numSource number of sources
+ */
+void placeSources(Grid *grid, const source_point *listSources, int numSource);
+
+/**
+ * print the delta value and the grid, as printf("%lf\n") and printf("%.4f,") would
+ * @param out the output
+ * @param grid the grid
+ * @param delta the delta
+ */
+void printGrid(Output *out, const Grid *grid, double delta);
+
+/**
+ * print the delta value and a float grid, like printGrid
+ * @param out the output
+ * @param grid the grid
+ * @param delta the delta
+ */
+void printFloatGrid(Output *out, const FloatGrid *grid, double delta);
+
+#endif //READER_H
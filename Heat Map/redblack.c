@@ -0,0 +1,280 @@
+/**
+ * @file redblack.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief red-black sweep of the grid, with SIMD kernels for the average stencil
+ */
+
+// ------------------------------ includes --------------------------------
+#include "sum.h"
+#include "sweep.h"
+#include "solver.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#else
+#define HAVE_X86_SIMD 0
+#endif
+
+// -------------------------- const definitions -------------------------
+#define SUM_LANES 4
+
+/**
+ * calculate the points of one colour in the points from..to-1 of a row with the average stencil
+ * @param row the row
+ * @param up the row above
+ * @param down the row below
+ * @param from first point
+ * @param to after the last point
+ * @param parity the points y with y % 2 == parity are calculated
+ */
+typedef void (*AverageRun)(double *row, const double *up, const double *down, int from, int to, int parity);
+
+// ------------------------------ functions -------------------------------
+/**
+ * calculate the points of one colour of a run with the average stencil, one by one
+ * @param row the row
+ * @param up the row above
+ * @param down the row below
+ * @param from first point
+ * @param to after the last point
+ * @param parity the points y with y % 2 == parity are calculated
+ */
+static void averageRunScalar(double *row, const double *up, const double *down, int from, int to, int parity)
+{
+    for (int y = from + ((from & 1) != parity); y < to; y += 2)
+    {
+        row[y] = (row[y + 1] + up[y] + row[y - 1] + down[y]) * 0.25;
+    }
+}
+
+#if HAVE_X86_SIMD
+/**
+ * calculate the points of one colour of a run with the average stencil, two points at a time
+ * The average is calculated for all the points and only kept for the points of the colour: they only read points of
+ * the other colour, which this pass doesn't change. The row is loaded one chunk ahead of the store, so a load never
+ * reads back a chunk which was just stored (it would wait for the store to be forwarded).
+ * @param row the row
+ * @param up the row above
+ * @param down the row below
+ * @param from first point
+ * @param to after the last point
+ * @param parity the points y with y % 2 == parity are calculated
+ */
+__attribute__((target("sse2")))
+static void averageRunSse2(double *row, const double *up, const double *down, int from, int to, int parity)
+{
+    const __m128d quarter = _mm_set1_pd(0.25);
+    const __m128d keep = (from & 1) == parity ? _mm_castsi128_pd(_mm_set_epi64x(0, -1))
+                                               : _mm_castsi128_pd(_mm_set_epi64x(-1, 0));
+    int y = from;
+    __m128d left = _mm_loadu_pd(row + y - 1), current = _mm_loadu_pd(row + y), right = _mm_loadu_pd(row + y + 1);
+    for (; y + 2 <= to; y += 2)
+    {
+        __m128d nextLeft = _mm_loadu_pd(row + y + 1), next = _mm_loadu_pd(row + y + 2);
+        __m128d nextRight = _mm_loadu_pd(row + y + 3);
+        __m128d sum = _mm_add_pd(right, _mm_loadu_pd(up + y));
+        sum = _mm_add_pd(sum, left);
+        sum = _mm_add_pd(sum, _mm_loadu_pd(down + y));
+        __m128d average = _mm_mul_pd(sum, quarter);
+        _mm_storeu_pd(row + y, _mm_or_pd(_mm_and_pd(keep, average), _mm_andnot_pd(keep, current)));
+        left = nextLeft;
+        current = next;
+        right = nextRight;
+    }
+    averageRunScalar(row, up, down, y, to, parity);
+}
+
+/**
+ * calculate the points of one colour of a run with the average stencil, four points at a time, like averageRunSse2
+ * @param row the row
+ * @param up the row above
+ * @param down the row below
+ * @param from first point
+ * @param to after the last point
+ * @param parity the points y with y % 2 == parity are calculated
+ */
+__attribute__((target("avx2")))
+static void averageRunAvx2(double *row, const double *up, const double *down, int from, int to, int parity)
+{
+    const __m256d quarter = _mm256_set1_pd(0.25);
+    const __m256d keep = (from & 1) == parity ? _mm256_castsi256_pd(_mm256_set_epi64x(0, -1, 0, -1))
+                                               : _mm256_castsi256_pd(_mm256_set_epi64x(-1, 0, -1, 0));
+    int y = from;
+    __m256d left = _mm256_loadu_pd(row + y - 1), current = _mm256_loadu_pd(row + y);
+    __m256d right = _mm256_loadu_pd(row + y + 1);
+    for (; y + 4 <= to; y += 4)
+    {
+        __m256d nextLeft = _mm256_loadu_pd(row + y + 3), next = _mm256_loadu_pd(row + y + 4);
+        __m256d nextRight = _mm256_loadu_pd(row + y + 5);
+        __m256d sum = _mm256_add_pd(right, _mm256_loadu_pd(up + y));
+        sum = _mm256_add_pd(sum, left);
+        sum = _mm256_add_pd(sum, _mm256_loadu_pd(down + y));
+        __m256d average = _mm256_mul_pd(sum, quarter);
+        _mm256_storeu_pd(row + y, _mm256_blendv_pd(current, average, keep));
+        left = nextLeft;
+        current = next;
+        right = nextRight;
+    }
+    averageRunScalar(row, up, down, y, to, parity);
+}
+#endif
+
+/**
+ * choose the average kernel
+ * @param simd the widest instructions allowed (SIMD_*)
+ * @return the kernel
+ */
+static AverageRun chooseAverageRun(int simd)
+{
+#if HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if ((simd == SIMD_AUTO || simd == SIMD_AVX2) && __builtin_cpu_supports("avx2"))
+    {
+        return averageRunAvx2;
+    }
+    if (simd != SIMD_SCALAR && __builtin_cpu_supports("sse2"))
+    {
+        return averageRunSse2;
+    }
+#else
+    (void) simd;
+#endif
+    return averageRunScalar;
+}
+
+/**
+ * calculate the points of one colour of a row, skipping the sources
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @param x the row
+ * @param colour RED or BLACK
+ * @param run the average kernel, NULL to call the heat function (and over-relax its value if omega is not 1)
+ */
+static void redBlackRow(const SweepState *state, int x, int colour, AverageRun run)
+{
+    const Grid *grid = state->grid;
+    ptrdiff_t stride = (ptrdiff_t) grid->stride;
+    double *row = GRID_ROW(grid, x);
+    const int *source = state->index.pos + state->index.start[x];
+    const int *lastSource = state->index.pos + state->index.start[x + 1];
+    int m = (int) grid->m, parity = (int) ((colour + x + state->firstRow) & 1), y = 0;
+
+    while (y < m)
+    {
+        int stop = source < lastSource ? *source : m;
+        if (run != NULL)
+        {
+            run(row, row - stride, row + stride, y, stop, parity);
+        }
+        else
+        {
+            for (int i = y + ((y & 1) != parity); i < stop; i += 2)
+            {
+                double value = state->function(row[i], row[i + 1], row[i - stride], row[i - 1], row[i + stride]);
+                row[i] = state->omega != 1 ? row[i] + state->omega * (value - row[i]) : value;
+            }
+        }
+        y = stop + 1; // the source keeps its value
+        ++source;
+    }
+}
+
+/**
+ * sum a row, in four interleaved partial sums so the additions don't wait for each other
+ * @param row the row
+ * @param m length
+ * @param sum the sum so far
+ * @return the sum with the row added
+ */
+static double sumRow(const double *row, int m, double sum)
+{
+    double partial[SUM_LANES] = {0};
+    int y = 0;
+    for (; y + SUM_LANES <= m; y += SUM_LANES)
+    {
+        for (int i = 0; i < SUM_LANES; ++i)
+        {
+            partial[i] += row[y + i];
+        }
+    }
+    for (; y < m; ++y)
+    {
+        partial[0] += row[y];
+    }
+    return sum + ((partial[0] + partial[1]) + (partial[2] + partial[3]));
+}
+
+/**
+ * calculate the points of one colour of the rows from..to-1
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @param colour RED or BLACK
+ * @param from first row
+ * @param to after the last row
+ * @return the sum of the rows, added row after row, if the colour is BLACK (the rows are finished) and rowSums is
+ * NULL, 0 otherwise
+ */
+double redBlackPass(SweepState *state, int colour, int from, int to)
+{
+    AverageRun run = state->stencil == STENCIL_AVERAGE && state->omega == 1 ? chooseAverageRun(state->simd) : NULL;
+    double sum = 0;
+    for (int x = from; x < to; ++x)
+    {
+        redBlackRow(state, x, colour, run);
+        if (colour == BLACK && state->rowSums != NULL)
+        { // added up by the caller, in the order of the rows of the whole grid
+            state->rowSums[state->firstRow + (size_t) x] = pairwiseSum(GRID_ROW(state->grid, x), state->grid->m);
+        }
+        else if (colour == BLACK)
+        {
+            sum = sumRow(GRID_ROW(state->grid, x), (int) state->grid->m, sum);
+        }
+    }
+    return sum;
+}
+
+/**
+ * calculate for each points on the grid the new heat, the red points (x + y even) then the black ones
+ * Without cyclic edges the two passes are done together: the black points of a row only need the red points of the
+ * rows around it, so row x - 1 is finished right after the red points of row x. A cyclic grid needs all the red
+ * points before its first black row, so the passes are apart and the ghost layer is filled again between them.
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @return the sum of the points on the grid, added row after row, or pairwise from rowSums if it is not NULL
+ */
+double calculateOneRedBlack(SweepState *state)
+{
+    Grid *grid = state->grid;
+    int n = (int) grid->n, m = (int) grid->m;
+    AverageRun run = state->stencil == STENCIL_AVERAGE && state->omega == 1 ? chooseAverageRun(state->simd) : NULL;
+    double sum = 0;
+
+    fillHalo(grid, state->is_cyclic);
+    if (!state->is_cyclic)
+    {
+        for (int x = 0; x <= n; ++x)
+        {
+            if (x < n)
+            {
+                redBlackRow(state, x, RED, run);
+            }
+            if (x > 0)
+            {
+                redBlackRow(state, x - 1, BLACK, run);
+                if (state->rowSums != NULL)
+                {
+                    state->rowSums[x - 1] = pairwiseSum(GRID_ROW(grid, x - 1), grid->m);
+                }
+                else
+                {
+                    sum = sumRow(GRID_ROW(grid, x - 1), m, sum);
+                }
+            }
+        }
+        return state->rowSums != NULL ? pairwiseSum(state->rowSums, grid->n) : sum;
+    }
+    redBlackPass(state, RED, 0, n);
+    fillHalo(grid, state->is_cyclic);
+    sum = redBlackPass(state, BLACK, 0, n);
+    return state->rowSums != NULL ? pairwiseSum(state->rowSums, grid->n) : sum;
+}
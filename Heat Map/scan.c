@@ -0,0 +1,259 @@
+/**
+ * @file scan.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief hand-written scanning of the source lines of the input
+ */
+
+// ------------------------------ includes --------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scan.h"
+
+// -------------------------- const definitions -------------------------
+#define SCAN_OK 0
+#define SCAN_FAIL 1
+#define SCAN_SLOW 2
+#define MAX_INT_DIGITS 9
+#define MAX_EXACT_MANTISSA 9007199254740992ULL
+#define MAX_EXACT_POWER 22
+#define MAX_MANTISSA_DIGITS 19
+#define SOURCE_FORMAT "%d, %d, %lf"
+
+static const double POWERS[MAX_EXACT_POWER + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+                                                   1e22};
+
+// ------------------------------ functions -------------------------------
+/**
+ * tell if a character is a space for scanf (in the C locale)
+ * @param c the character
+ * @return 1 if it is and 0 if not
+ */
+static int isSpace(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * tell if a character is a digit
+ * @param c the character
+ * @return 1 if it is and 0 if not
+ */
+static int isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * skip the spaces
+ * @param cursor the position, moved after the spaces
+ * @param end end of the line
+ */
+static void skipSpaces(const char **cursor, const char *end)
+{
+    while (*cursor < end && isSpace(**cursor))
+    {
+        ++*cursor;
+    }
+}
+
+/**
+ * read an int like %d
+ * @param cursor the position, moved after the number
+ * @param end end of the line
+ * @param value set to the number
+ * @return SCAN_OK, SCAN_FAIL if there is no number, SCAN_SLOW if it is too long to be sure it fits
+ */
+static int scanInt(const char **cursor, const char *end, int *value)
+{
+    const char *p = *cursor;
+    int negative = 0, digits = 0;
+    long number = 0;
+
+    skipSpaces(&p, end);
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+    for (; p < end && isDigit(*p); ++p, ++digits)
+    {
+        if (digits == MAX_INT_DIGITS)
+        {
+            return SCAN_SLOW;
+        }
+        number = number * 10 + (*p - '0');
+    }
+    if (digits == 0)
+    {
+        return SCAN_FAIL;
+    }
+    *value = (int) (negative ? -number : number);
+    *cursor = p;
+    return SCAN_OK;
+}
+
+/**
+ * read a double like %lf, when it can be done exactly with one multiplication or division: up to 2^53 for the
+ * digits and a power of ten up to 10^22 (the powers which are exact doubles)
+ * @param cursor the position
+ * @param end end of the line
+ * @param value set to the number
+ * @return SCAN_OK or SCAN_SLOW if strtod must do it (no digits, which is also inf and nan, hexadecimal, too many
+ *         digits, a big exponent or an exponent without digits)
+ */
+static int scanDouble(const char **cursor, const char *end, double *value)
+{
+    const char *p = *cursor;
+    int negative = 0, digits = 0, significant = 0, exponent = 0;
+    uint64_t mantissa = 0;
+
+    skipSpaces(&p, end);
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+    for (; p < end && isDigit(*p); ++p, ++digits)
+    {
+        significant += mantissa > 0 || *p != '0';
+        mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+        if (significant > MAX_MANTISSA_DIGITS - 1)
+        {
+            return SCAN_SLOW;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && isDigit(*p); ++p, ++digits)
+        {
+            significant += mantissa > 0 || *p != '0';
+            mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+            --exponent;
+            if (significant > MAX_MANTISSA_DIGITS - 1)
+            {
+                return SCAN_SLOW;
+            }
+        }
+    }
+    if (digits == 0)
+    { // maybe inf or nan, or no number
+        return SCAN_SLOW;
+    }
+    if (p < end && (*p == 'x' || *p == 'X' || *p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        int sign = 1, power = 0;
+        if (*p == 'x' || *p == 'X')
+        {
+            return SCAN_SLOW;
+        }
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            sign = *q == '-' ? -1 : 1;
+            ++q;
+        }
+        if (q == end || !isDigit(*q))
+        {
+            return SCAN_SLOW;
+        }
+        for (; q < end && isDigit(*q); ++q)
+        {
+            if (power > MAX_EXACT_POWER * 2)
+            {
+                return SCAN_SLOW;
+            }
+            power = power * 10 + (*q - '0');
+        }
+        exponent += sign * power;
+    }
+    if (mantissa > MAX_EXACT_MANTISSA || exponent > MAX_EXACT_POWER || exponent < -MAX_EXACT_POWER)
+    {
+        return SCAN_SLOW;
+    }
+    double number = exponent < 0 ? (double) mantissa / POWERS[-exponent] : (double) mantissa * POWERS[exponent];
+    *value = negative ? -number : number;
+    return SCAN_OK;
+}
+
+/**
+ * read a character which must be there
+ * @param cursor the position, moved after the character
+ * @param end end of the line
+ * @param c the character
+ * @return SCAN_OK or SCAN_FAIL
+ */
+static int scanChar(const char **cursor, const char *end, char c)
+{
+    if (*cursor == end || **cursor != c)
+    {
+        return SCAN_FAIL;
+    }
+    ++*cursor;
+    return SCAN_OK;
+}
+
+/**
+ * read a source line with sscanf, for the lines scanSourceLine can't be sure of
+ * @param line the line
+ * @param end after the last character of the line
+ * @param x set to the x coordinate
+ * @param y set to the y coordinate
+ * @param value set to the value
+ * @return 0 if the line has the three fields and 1 if not
+ */
+static int scanSourceLineSlow(const char *line, const char *end, int *x, int *y, double *value)
+{
+    size_t length = (size_t) (end - line);
+    char *copy = (char *) malloc(length + 1);
+    if (copy == NULL)
+    {
+        return 1;
+    }
+    memcpy(copy, line, length);
+    copy[length] = '\0';
+    int failed = sscanf(copy, SOURCE_FORMAT, x, y, value) != 3;
+    free(copy);
+    return failed;
+}
+
+/**
+ * read a source line like sscanf(line, "%d, %d, %lf", x, y, value) == 3 does
+ * the fields are read by hand, a line with a field the fast path can't be sure of is given to sscanf
+ * @param line the line, not ended by '\0'
+ * @param end after the last character of the line
+ * @param x set to the x coordinate
+ * @param y set to the y coordinate
+ * @param value set to the value
+ * @return 0 if the line has the three fields and 1 if not
+ */
+int scanSourceLine(const char *line, const char *end, int *x, int *y, double *value)
+{
+    const char *p = line;
+    int result = scanInt(&p, end, x);
+    if (result == SCAN_OK)
+    {
+        result = scanChar(&p, end, ',');
+    }
+    if (result == SCAN_OK)
+    {
+        result = scanInt(&p, end, y);
+    }
+    if (result == SCAN_OK)
+    {
+        result = scanChar(&p, end, ',');
+    }
+    if (result == SCAN_OK)
+    {
+        result = scanDouble(&p, end, value);
+    }
+    if (result == SCAN_SLOW)
+    {
+        return scanSourceLineSlow(line, end, x, y, value);
+    }
+    return result != SCAN_OK;
+}
@@ -0,0 +1,23 @@
+/**
+ * @file scan.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief hand-written scanning of the source lines of the input
+ */
+#ifndef SCAN_H
+#define SCAN_H
+
+// ------------------------------ functions -------------------------------
+/**
+ * read a source line like sscanf(line, "%d, %d, %lf", x, y, value) == 3 does
+ * @param line the line, not ended by '\0'
+ * @param end after the last character of the line
+ * @param x set to the x coordinate
+ * @param y set to the y coordinate
+ * @param value set to the value
+ * @return 0 if the line has the three fields and 1 if not
+ */
+int scanSourceLine(const char *line, const char *end, int *x, int *y, double *value);
+
+#endif //SCAN_H
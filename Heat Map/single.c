@@ -0,0 +1,439 @@
+/**
+ * @file single.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief sweeps of a grid stored as float, for the single and mixed precisions
+ */
+
+// ------------------------------ includes --------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "profile.h"
+#include "solver.h"
+#include "sweep.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#else
+#define HAVE_X86_SIMD 0
+#endif
+
+// -------------------------- const definitions -------------------------
+#define SUM_LANES 4
+
+/**
+ * calculate the points of one colour in the points from..to-1 of a float row with the average stencil
+ * @param row the row
+ * @param up the row above
+ * @param down the row below
+ * @param from first point
+ * @param to after the last point
+ * @param parity the points y with y % 2 == parity are calculated
+ */
+typedef void (*FloatAverageRun)(float *row, const float *up, const float *down, int from, int to, int parity);
+
+/**
+ * What the sweeps of a float grid need, set up once by calculateFloatGrid. index groups the sources by row, average
+ * is the red-black kernel of STENCIL_AVERAGE (NULL to call function), precision tells in what the sums are added.
+ * omega is the over-relaxation factor, as in SweepState.
+ */
+typedef struct FloatSweep
+{
+    diff_func function;
+    double omega;
+    FloatGrid *grid;
+    SourceIndex index;
+    int is_cyclic;
+    int precision;
+    FloatAverageRun average;
+} FloatSweep;
+
+// ------------------------------ functions -------------------------------
+/**
+ * calculate the points of one colour of a float run with the average stencil, one by one
+ * @param row the row
+ * @param up the row above
+ * @param down the row below
+ * @param from first point
+ * @param to after the last point
+ * @param parity the points y with y % 2 == parity are calculated
+ */
+static void floatAverageScalar(float *row, const float *up, const float *down, int from, int to, int parity)
+{
+    for (int y = from + ((from & 1) != parity); y < to; y += 2)
+    {
+        row[y] = (row[y + 1] + up[y] + row[y - 1] + down[y]) * 0.25f;
+    }
+}
+
+#if HAVE_X86_SIMD
+/**
+ * calculate the points of one colour of a float run with the average stencil, four points at a time, like the
+ * kernels of redblack.c
+ * @param row the row
+ * @param up the row above
+ * @param down the row below
+ * @param from first point
+ * @param to after the last point
+ * @param parity the points y with y % 2 == parity are calculated
+ */
+__attribute__((target("sse2")))
+static void floatAverageSse2(float *row, const float *up, const float *down, int from, int to, int parity)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 keep = (from & 1) == parity ? _mm_castsi128_ps(_mm_set_epi32(0, -1, 0, -1))
+                                             : _mm_castsi128_ps(_mm_set_epi32(-1, 0, -1, 0));
+    int y = from;
+    __m128 left = _mm_loadu_ps(row + y - 1), current = _mm_loadu_ps(row + y), right = _mm_loadu_ps(row + y + 1);
+    for (; y + 4 <= to; y += 4)
+    {
+        __m128 nextLeft = _mm_loadu_ps(row + y + 3), next = _mm_loadu_ps(row + y + 4);
+        __m128 nextRight = _mm_loadu_ps(row + y + 5);
+        __m128 sum = _mm_add_ps(right, _mm_loadu_ps(up + y));
+        sum = _mm_add_ps(sum, left);
+        sum = _mm_add_ps(sum, _mm_loadu_ps(down + y));
+        __m128 average = _mm_mul_ps(sum, quarter);
+        _mm_storeu_ps(row + y, _mm_or_ps(_mm_and_ps(keep, average), _mm_andnot_ps(keep, current)));
+        left = nextLeft;
+        current = next;
+        right = nextRight;
+    }
+    floatAverageScalar(row, up, down, y, to, parity);
+}
+
+/**
+ * calculate the points of one colour of a float run with the average stencil, eight points at a time
+ * @param row the row
+ * @param up the row above
+ * @param down the row below
+ * @param from first point
+ * @param to after the last point
+ * @param parity the points y with y % 2 == parity are calculated
+ */
+__attribute__((target("avx2")))
+static void floatAverageAvx2(float *row, const float *up, const float *down, int from, int to, int parity)
+{
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 keep = (from & 1) == parity ? _mm256_castsi256_ps(_mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1))
+                                             : _mm256_castsi256_ps(_mm256_set_epi32(-1, 0, -1, 0, -1, 0, -1, 0));
+    int y = from;
+    __m256 left = _mm256_loadu_ps(row + y - 1), current = _mm256_loadu_ps(row + y);
+    __m256 right = _mm256_loadu_ps(row + y + 1);
+    for (; y + 8 <= to; y += 8)
+    {
+        __m256 nextLeft = _mm256_loadu_ps(row + y + 7), next = _mm256_loadu_ps(row + y + 8);
+        __m256 nextRight = _mm256_loadu_ps(row + y + 9);
+        __m256 sum = _mm256_add_ps(right, _mm256_loadu_ps(up + y));
+        sum = _mm256_add_ps(sum, left);
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(down + y));
+        __m256 average = _mm256_mul_ps(sum, quarter);
+        _mm256_storeu_ps(row + y, _mm256_blendv_ps(current, average, keep));
+        left = nextLeft;
+        current = next;
+        right = nextRight;
+    }
+    floatAverageScalar(row, up, down, y, to, parity);
+}
+#endif
+
+/**
+ * choose the float average kernel
+ * @param simd the widest instructions allowed (SIMD_*)
+ * @return the kernel
+ */
+static FloatAverageRun chooseFloatAverage(int simd)
+{
+#if HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if ((simd == SIMD_AUTO || simd == SIMD_AVX2) && __builtin_cpu_supports("avx2"))
+    {
+        return floatAverageAvx2;
+    }
+    if (simd != SIMD_SCALAR && __builtin_cpu_supports("sse2"))
+    {
+        return floatAverageSse2;
+    }
+#else
+    (void) simd;
+#endif
+    return floatAverageScalar;
+}
+
+/**
+ * add a row to the sum of a sweep, in float or in double, in four interleaved partial sums like sumRow
+ * @param row the row
+ * @param m length
+ * @param precision PRECISION_FLOAT or PRECISION_MIXED
+ * @param sum the sum so far
+ * @return the sum with the row added
+ */
+static double sumFloatRow(const float *row, int m, int precision, double sum)
+{
+    int y = 0;
+    if (precision == PRECISION_FLOAT)
+    {
+        float partial[SUM_LANES] = {0};
+        for (; y + SUM_LANES <= m; y += SUM_LANES)
+        {
+            for (int i = 0; i < SUM_LANES; ++i)
+            {
+                partial[i] += row[y + i];
+            }
+        }
+        for (; y < m; ++y)
+        {
+            partial[0] += row[y];
+        }
+        return (float) sum + ((partial[0] + partial[1]) + (partial[2] + partial[3]));
+    }
+    double partial[SUM_LANES] = {0};
+    for (; y + SUM_LANES <= m; y += SUM_LANES)
+    {
+        for (int i = 0; i < SUM_LANES; ++i)
+        {
+            partial[i] += row[y + i];
+        }
+    }
+    for (; y < m; ++y)
+    {
+        partial[0] += row[y];
+    }
+    return sum + ((partial[0] + partial[1]) + (partial[2] + partial[3]));
+}
+
+/**
+ * calculate the points from..to-1 of a float row with the heat function, in the row-major order
+ * @param sweep the sweep
+ * @param row the row
+ * @param from first point
+ * @param to after the last point
+ */
+static void floatRun(const FloatSweep *sweep, float *row, int from, int to)
+{
+    ptrdiff_t stride = (ptrdiff_t) sweep->grid->stride;
+    for (int y = from; y < to; ++y)
+    {
+        double value = sweep->function(row[y], row[y + 1], row[y - stride], row[y - 1], row[y + stride]);
+        row[y] = (float) (sweep->omega != 1 ? row[y] + sweep->omega * (value - row[y]) : value);
+    }
+}
+
+/**
+ * calculate for each points on the float grid the new heat, row after row
+ * The copies of the first row and of the first column in the ghost layer are refreshed as soon as they are
+ * calculated, like in calculateOneTiled, so it is the Gauss-Seidel order of the double grid.
+ * @param sweep the sweep
+ * @return the sum of the points on the grid, added row after row
+ */
+static double floatSweepRows(FloatSweep *sweep)
+{
+    FloatGrid *grid = sweep->grid;
+    int n = (int) grid->n, m = (int) grid->m;
+    double sum = 0;
+
+    fillFloatHalo(grid, sweep->is_cyclic);
+    for (int x = 0; x < n; ++x)
+    {
+        float *row = GRID_ROW(grid, x);
+        const int *source = sweep->index.pos + sweep->index.start[x];
+        const int *lastSource = sweep->index.pos + sweep->index.start[x + 1];
+        int y = 0;
+        while (y < m)
+        {
+            int stop = source < lastSource ? *source : m;
+            if (y == 0 && stop > 0 && sweep->is_cyclic)
+            {
+                floatRun(sweep, row, 0, 1);
+                row[m] = row[0];
+                y = 1;
+            }
+            floatRun(sweep, row, y, stop);
+            y = stop + 1; // the source keeps its value
+            ++source;
+        }
+        if (x == 0 && sweep->is_cyclic)
+        {
+            memcpy(GRID_ROW(grid, n), row, sizeof(float) * (size_t) m);
+        }
+        sum = sumFloatRow(row, m, sweep->precision, sum);
+    }
+    return sum;
+}
+
+/**
+ * calculate the points of one colour of a float row, skipping the sources
+ * @param sweep the sweep
+ * @param x the row
+ * @param colour RED or BLACK
+ */
+static void floatRedBlackRow(const FloatSweep *sweep, int x, int colour)
+{
+    const FloatGrid *grid = sweep->grid;
+    ptrdiff_t stride = (ptrdiff_t) grid->stride;
+    float *row = GRID_ROW(grid, x);
+    const int *source = sweep->index.pos + sweep->index.start[x];
+    const int *lastSource = sweep->index.pos + sweep->index.start[x + 1];
+    int m = (int) grid->m, parity = (colour + x) & 1, y = 0;
+
+    while (y < m)
+    {
+        int stop = source < lastSource ? *source : m;
+        if (sweep->average != NULL)
+        {
+            sweep->average(row, row - stride, row + stride, y, stop, parity);
+        }
+        else
+        {
+            for (int i = y + ((y & 1) != parity); i < stop; i += 2)
+            {
+                double value = sweep->function(row[i], row[i + 1], row[i - stride], row[i - 1], row[i + stride]);
+                row[i] = (float) (sweep->omega != 1 ? row[i] + sweep->omega * (value - row[i]) : value);
+            }
+        }
+        y = stop + 1; // the source keeps its value
+        ++source;
+    }
+}
+
+/**
+ * calculate for each points on the float grid the new heat, the red points then the black ones, like
+ * calculateOneRedBlack
+ * @param sweep the sweep
+ * @return the sum of the points on the grid, added row after row
+ */
+static double floatSweepRedBlack(FloatSweep *sweep)
+{
+    FloatGrid *grid = sweep->grid;
+    int n = (int) grid->n, m = (int) grid->m;
+    double sum = 0;
+
+    fillFloatHalo(grid, sweep->is_cyclic);
+    if (!sweep->is_cyclic)
+    {
+        for (int x = 0; x <= n; ++x)
+        {
+            if (x < n)
+            {
+                floatRedBlackRow(sweep, x, RED);
+            }
+            if (x > 0)
+            {
+                floatRedBlackRow(sweep, x - 1, BLACK);
+                sum = sumFloatRow(GRID_ROW(grid, x - 1), m, sweep->precision, sum);
+            }
+        }
+        return sum;
+    }
+    for (int x = 0; x < n; ++x)
+    {
+        floatRedBlackRow(sweep, x, RED);
+    }
+    fillFloatHalo(grid, sweep->is_cyclic);
+    for (int x = 0; x < n; ++x)
+    {
+        floatRedBlackRow(sweep, x, BLACK);
+        sum = sumFloatRow(GRID_ROW(grid, x), m, sweep->precision, sum);
+    }
+    return sum;
+}
+
+/**
+ * Same as calculateFloatGrid() but returns an error instead of printing it and exiting.
+ * @param function function that calculate the temperature of a coordinate
+ * @param grid the grid
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param options how to sweep, precision is PRECISION_FLOAT or PRECISION_MIXED
+ * @param result set to the difference between the sums of the two last sweeps
+ * @return HEAT_OK, HEAT_ERROR_MEMORY or HEAT_ERROR_PRECISION (the stencil reads the diagonals)
+ */
+int tryCalculateFloatGrid(diff_func function, FloatGrid *grid, const source_point *sources, size_t num_sources,
+                          double terminate, unsigned int n_iter, int is_cyclic, const SolverOptions *options,
+                          double *result)
+{
+    const Stencil *stencil = findStencil(options->stencil);
+    FloatSweep sweep;
+    double sum = 0, previousSum = 0, delta = 0;
+    unsigned long done = 0;
+    ProfileMark call, mark;
+
+    if (profileLevel)
+    {
+        profileMark(&call);
+    }
+    if (stencil->diagonals)
+    {
+        return HEAT_ERROR_PRECISION;
+    }
+    sweep.function = stencil->function != NULL ? stencil->function : function;
+    sweep.grid = grid;
+    sweep.is_cyclic = is_cyclic;
+    sweep.precision = options->precision;
+    sweep.omega = chooseOmega(options->omega, grid->n, grid->m, is_cyclic, options->stencil);
+    sweep.average = options->stencil == STENCIL_AVERAGE && sweep.omega == 1 ? chooseFloatAverage(options->simd) : NULL;
+    if (buildSourceIndex(&sweep.index, sources, num_sources, grid->n, grid->m, SOURCES_BY_ROW))
+    {
+        return HEAT_ERROR_MEMORY;
+    }
+    double (*run)(FloatSweep *) = options->order == ORDER_RED_BLACK ? floatSweepRedBlack : floatSweepRows;
+
+    while (n_iter > 0 ? done < n_iter : done == 0 || delta > terminate || -delta > terminate)
+    {
+        if (profileLevel)
+        {
+            profileMark(&mark);
+        }
+        previousSum = sum;
+        sum = run(&sweep);
+        delta = sum - previousSum;
+        ++done;
+        if (profileLevel)
+        {
+            profileSweep(&mark, delta);
+        }
+    }
+    freeSourceIndex(&sweep.index);
+    if (options->sweeps != NULL)
+    {
+        *options->sweeps += done;
+    }
+    if (profileLevel)
+    {
+        profileSweeps(done, delta);
+        profilePhase(PHASE_CALCULATE, &call);
+    }
+    *result = delta;
+    return HEAT_OK;
+}
+
+/**
+ * Same as calculateGrid() but on a grid stored as float.
+ * @param function function that calculate the temperature of a coordinate
+ * @param grid the grid
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param options how to sweep, precision is PRECISION_FLOAT or PRECISION_MIXED and stencil a 5-point one
+ * @return the difference between the sums of the two last sweeps
+ */
+double calculateFloatGrid(diff_func function, FloatGrid *grid, const source_point *sources, size_t num_sources,
+                          double terminate, unsigned int n_iter, int is_cyclic, const SolverOptions *options)
+{
+    double delta = 0;
+    int status = tryCalculateFloatGrid(function, grid, sources, num_sources, terminate, n_iter, is_cyclic, options,
+                                       &delta);
+    if (status != HEAT_OK)
+    {
+        fprintf(stderr, "%s", statusMessage(status));
+        exit(1);
+    }
+    return delta;
+}
@@ -0,0 +1,323 @@
+/**
+ * @file solver.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief calculator entry points working on a contiguous grid
+ */
+#ifndef SOLVER_H
+#define SOLVER_H
+
+// ------------------------------ includes --------------------------------
+#include "calculator.h"
+#include "grid.h"
+#include "pool.h"
+#include "sources.h"
+#include "status.h"
+
+// -------------------------- const definitions -------------------------
+#define BOUNDARY_HALO 0
+#define BOUNDARY_BRANCH 1
+
+#define ORDER_COLUMN 0
+#define ORDER_ROW 1
+#define ORDER_TILED 2
+#define ORDER_RED_BLACK 3
+
+#define STENCIL_FUNCTION 0
+#define STENCIL_AVERAGE 1
+#define STENCIL_WEIGHTED 2
+#define STENCIL_NINE_POINT 3
+
+#define SOLVER_SWEEP 0
+#define SOLVER_MULTIGRID 1
+
+#define PRECISION_DOUBLE 0
+#define PRECISION_FLOAT 1
+#define PRECISION_MIXED 2
+
+#define ACTIVE_OFF (-1.0)
+
+#define OMEGA_GAUSS_SEIDEL 1.0
+#define OMEGA_AUTO 0.0
+
+#define SUM_SWEEP 0
+#define SUM_PAIRWISE 1
+
+#define SIMD_AUTO 0
+#define SIMD_SCALAR 1
+#define SIMD_SSE2 2
+#define SIMD_AVX2 3
+
+#define WRITER_INLINE 0
+#define WRITER_THREAD 1
+
+#define FORMAT_TEXT 0
+#define FORMAT_PGM 1
+#define FORMAT_PPM 2
+
+/**
+ * Memory kept by the caller from one call of calculateGrid to the next, so the calls on grids of the same size
+ * allocate nothing: the index of the sources, the row cursors of the sweeps and the pool of threads. It starts set to
+ * 0 and is freed by freeWorkspace. The processes, the temporal blocks, the multigrid levels and the active tiles still
+ * allocate their memory in each call. Calls with separate workspaces don't share anything and can run at the same time.
+ */
+typedef struct SolverWorkspace
+{
+    SourceIndex index;
+    const int **cursor;
+    size_t cursorRows;
+    Pool *pool;
+} SolverWorkspace;
+
+/**
+ * called by calculateGrid after each sweep of the one-thread loop, and once at the end of the call for the other ways
+ * of sweeping (the threads, the processes, the temporal blocks and the multigrid cycles)
+ * @param data the progressData of the options
+ * @param sweeps number of sweeps of the call so far
+ * @param delta the difference between the sums of the two last sweeps
+ * @return 0 to go on and not 0 to stop the call
+ */
+typedef int (*ProgressFunction)(void *data, unsigned long sweeps, double delta);
+
+/**
+ * How calculateGrid sweeps the grid. Each field can be set with --name=value on the command line or with the
+ * environment variable HEAT_NAME (see options.c).
+ * boundary: BOUNDARY_HALO reads the neighbours of the edges from the ghost layer filled once per sweep,
+ *           BOUNDARY_BRANCH checks the four edges for every point (grids without ghost layer always do this).
+ * order: the order of the points in a sweep. ORDER_COLUMN is the original one (y outside, x inside), ORDER_ROW walks
+ *        the grid in memory order and ORDER_TILED walks it tile by tile, tiles of tileRows*tileCols points (0 to size
+ *        them from the caches). In all of them a point reads the new values of its top and left neighbours and the
+ *        old values of the two others, so they calculate the same grid. Only the order of the sum changes, which can
+ *        move the last digits of delta.
+ *        ORDER_RED_BLACK calculates the points with x + y even, then the points with x + y odd, so the points of a
+ *        pass only read points of the other colour and a pass can be vectorised. It converges differently from the
+ *        other orders, and always reads the edges from the ghost layer (ORDER_ROW is used on grids without one).
+ * stencil: STENCIL_FUNCTION calls the function given to calculateGrid for each point, the other ones use a built-in
+ *          stencil instead (see stencil.h), inlined in the sweeps reading the ghost layer: STENCIL_AVERAGE is the
+ *          average of the four neighbours (with a SIMD kernel in ORDER_RED_BLACK), STENCIL_WEIGHTED keeps half of the
+ *          point and STENCIL_NINE_POINT also reads the four diagonal neighbours. STENCIL_NINE_POINT needs a grid with
+ *          a ghost layer and is always swept in ORDER_COLUMN with one thread, the other orders would not calculate
+ *          the same grid with the diagonals.
+ * simd: the widest instructions the SIMD kernels may use, SIMD_AUTO picks the best one the CPU supports. A level the
+ *       CPU doesn't support falls back to the best one it does, all levels calculate the same values.
+ * activeThreshold: ACTIVE_OFF, or sweep tile by tile in ORDER_TILED and skip the tiles which can't change (see
+ *                  calculateOneActive): a tile is calculated only if a point of it or of the tiles around it moved by
+ *                  more than activeThreshold the last time they were calculated, the other tiles keep their points and
+ *                  their sum. With 0 it is the grid of ORDER_TILED, only faster where the grid is still 0 or has
+ *                  stopped moving; above 0 the points which move slower than that are left behind. The tiles are
+ *                  32*32 unless tileRows and tileCols are set. It is not used with ORDER_RED_BLACK, the threads, the
+ *                  processes, the nine-point stencil, the multigrid solver and the float grids.
+ * threads: number of threads calculating the grid, 0 for one per CPU. With more than one thread the grid is split in
+ *          bands of rows swept in the red-black order, the threads wait for each other between the colours. The
+ *          threads are kept alive between the calls.
+ * processes: number of worker processes calculating the grid, 0 for one per NUMA node and 1 for none. Like the
+ *            threads, each process sweeps a band of rows in the red-black order, but in its own memory, on the cpus
+ *            of one NUMA node: the processes exchange the edges of their bands through POSIX shared memory and add up
+ *            their sums there. It calculates the same grid as the threads, and is used instead of them.
+ * blockSweeps: with n_iter > 0, ORDER_ROW and a grid which is not cyclic, the number of sweeps done together while
+ *              the rows are in the cache (temporal blocking), 0 or 1 to do the sweeps one by one. Wide rows are cut
+ *              in strips sized from L2. The blocks calculate the same grid as the sweeps one by one, but with strips
+ *              they add up the sums row by row, so the delta can change in the last digits.
+ * solver: with n_iter == 0, SOLVER_SWEEP sweeps until the sums of two sweeps are closer than terminate.
+ *         SOLVER_MULTIGRID runs V-cycles instead (see multigrid.c): the sweeps smooth the grid and coarser grids
+ *         correct the smooth part of the error, until the sums of two cycles are closer than terminate. It needs a
+ *         grid with a ghost layer and a 5-point stencil, and a cyclic grid needs a source. It converges to the same
+ *         grid in far fewer sweeps, but the grid printed at the end is not the one of SOLVER_SWEEP, which stops
+ *         further from the limit.
+ * omega: the over-relaxation factor of the sweeps (successive over-relaxation), each point moves omega times as far
+ *        as the heat function moves it. OMEGA_GAUSS_SEIDEL (1) is the plain sweep, between 1 and 2 the sweeps
+ *        converge faster on large grids, and OMEGA_AUTO chooses the optimal factor of the average stencil from the
+ *        size of the grid and its edges (see chooseOmega). The grid converges to the same limit, but delta drops in
+ *        another way, so the grid printed at the end is not the one of the plain sweep. The SIMD kernels are only
+ *        used at 1, and the multigrid solver smooths with the plain sweep.
+ * sum: how the points are added up for delta. SUM_SWEEP adds them as the sweep goes, in its order, and the threads and
+ *      the processes add up the sums of their bands, so the rounding changes with their number. SUM_PAIRWISE sums
+ *      each row pairwise and the sums of the rows pairwise (see sum.h): the error of the sum grows with log(n * m)
+ *      instead of n * m, and the order only depends on the size of the grid, so the red-black sweeps give the same
+ *      deltas to the bit with any number of threads or processes. The red-black sweeps sum each row right after it
+ *      is finished, the other orders read the grid again after the sweep. The temporal blocks are not used, and the
+ *      multigrid cycles keep the sums of their sweeps. It only applies to the double grids.
+ * precision: how the points of a grid read from a text input are stored. PRECISION_DOUBLE is the Grid of
+ *            calculateGrid, PRECISION_FLOAT and PRECISION_MIXED store them as float (see calculateFloatGrid), which
+ *            halves the memory of the grid. PRECISION_FLOAT also adds up the sums of the sweeps in float, so delta
+ *            can't go much below the sum times 1e-7; PRECISION_MIXED adds them up in double. Binary grid files and
+ *            runs with a checkpoint stay in double.
+ * checkpoint: a binary grid file (see gridfile.h) written every checkpointEvery sweeps, NULL for none. The
+ *             checkpoints are written by the one-thread loop, so the threads and the temporal blocks are not used.
+ * profile: PROFILE_NONE, PROFILE_SUMMARY or PROFILE_TRACE, given to initProfile by the programs (see profile.h). The
+ *          summary has the wall and cpu times of the parsing, the calculate calls, the sweeps and the printing, and
+ *          the number of sweeps; the trace adds the delta and the time of each sweep. The temporal blocks and the
+ *          multigrid cycles are traced as a whole, their sweeps are only counted. The processes trace each sweep of
+ *          worker 0, but their times stay in it and are not in the summary.
+ * jobs: with several inputs (see batch.h), number of inputs solved at the same time, 0 for one per CPU.
+ * outputDir: with several inputs, the directory of the outputs, NULL to write each one next to its input.
+ * warmStart: a binary grid file (see gridfile.h) the grid of a text input starts from instead of 0, NULL for none.
+ *            It has the size of the input, usually the grid saved by an earlier run whose sources were moved or
+ *            changed since: the sources which differ from the ones of the file are the changes of the first call.
+ * save: a binary grid file written with the grid when the run ends, the warmStart of the next run, NULL for none.
+ * writer: WRITER_INLINE prints each grid of ex3 before the next call, WRITER_THREAD hands a copy of it to a writer
+ *         thread and calculates the next grid while it is printed (see writer.h). The output is the same.
+ * format: how ex3 prints the grid of each call. FORMAT_TEXT is the delta and the points as text, FORMAT_PGM and
+ *         FORMAT_PPM are a binary grey or colour frame (see image.h) with the delta in a comment, the frames of the
+ *         calls one after the other on stdout. The frames are block-averaged down to imageSize pixels on their largest
+ *         side (0 for a pixel per point).
+ * outOfCore: a directory the grid of a text input is mapped from a file of (see mapGrid) instead of allocated, for the
+ *            grids larger than the memory, NULL for none. The sweeps then go through the grid in bands of full rows,
+ *            in the order of the file, reading the next band ahead and writing back the ones done (tileRows rows,
+ *            about 16 MB if it is 0). The grid is the one of the row order; the threads, the processes, the multigrid
+ *            solver and the active tiles are not used, and the grid is in double.
+ * sweeps: if not NULL, the number of sweeps of each call is added to it (it is not an option).
+ * workspace: if not NULL, the memory the calls reuse (it is not an option).
+ * progress, progressData: if progress is not NULL, it is called with progressData as the sweeps go (they are not
+ *             options). When it returns not 0 the call stops, tryCalculateGrid returns HEAT_ERROR_STOPPED.
+ * changes, numChanges: if changes is not NULL, the grid had converged before the sources of these points changed (they
+ *             are not options). The call sweeps tile by tile like activeThreshold, starting with the tiles of the
+ *             changes only, the other tiles keep their points until a change reaches them. activeThreshold is the
+ *             threshold, terminate / (n * m) if it is ACTIVE_OFF: the points which move slower than that can't move
+ *             the sum by terminate. Without the tiled sweep (see activeThreshold), the whole grid is swept.
+ * resumeSweeps, resumeSum, resumeDelta: set from a checkpoint (they are not options), the call continues after
+ *             sweep resumeSweeps, whose sum was resumeSum and delta resumeDelta. 0 starts a new call.
+ */
+typedef struct SolverOptions
+{
+    int boundary;
+    int order;
+    size_t tileRows;
+    size_t tileCols;
+    int stencil;
+    int simd;
+    double activeThreshold;
+    int threads;
+    int processes;
+    size_t blockSweeps;
+    int solver;
+    double omega;
+    int sum;
+    int precision;
+    const char *checkpoint;
+    unsigned long checkpointEvery;
+    int profile;
+    int jobs;
+    const char *outputDir;
+    const char *warmStart;
+    const char *save;
+    int writer;
+    int format;
+    size_t imageSize;
+    const char *outOfCore;
+    unsigned long *sweeps;
+    SolverWorkspace *workspace;
+    ProgressFunction progress;
+    void *progressData;
+    const source_point *changes;
+    size_t numChanges;
+    unsigned long resumeSweeps;
+    double resumeSum;
+    double resumeDelta;
+} SolverOptions;
+
+// ------------------------------ functions -------------------------------
+/**
+ * Same as calculate() but on a contiguous grid.
+ * @param function function that calculate the temperature of a coordinate
+ * @param grid the grid
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param options how to sweep, NULL for the default options
+ * @return the difference between the sums of the two last sweeps
+ */
+double calculateGrid(diff_func function, Grid *grid, source_point *sources, size_t num_sources, double terminate,
+                     unsigned int n_iter, int is_cyclic, const SolverOptions *options);
+
+/**
+ * Same as calculateGrid() but returns an error instead of printing it and exiting.
+ * @param function function that calculate the temperature of a coordinate
+ * @param grid the grid
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param options how to sweep, NULL for the default options
+ * @param delta set to the difference between the sums of the two last sweeps
+ * @return HEAT_OK, HEAT_ERROR_MEMORY, HEAT_ERROR_HALO or HEAT_ERROR_STOPPED (delta is then the one of the last sweep)
+ */
+int tryCalculateGrid(diff_func function, Grid *grid, source_point *sources, size_t num_sources, double terminate,
+                     unsigned int n_iter, int is_cyclic, const SolverOptions *options, double *delta);
+
+/**
+ * free the memory of a workspace
+ * @param workspace the workspace
+ */
+void freeWorkspace(SolverWorkspace *workspace);
+
+/**
+ * Same as calculateGrid() but on a grid stored as float. The points are calculated by the heat function (or the
+ * built-in stencil) in double and rounded when stored, in the row-major order or in ORDER_RED_BLACK, where
+ * STENCIL_AVERAGE has SIMD kernels working on twice the points of the double ones. The grid is calculated by one
+ * thread, without temporal blocks or multigrid.
+ * @param function function that calculate the temperature of a coordinate
+ * @param grid the grid
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param options how to sweep, precision is PRECISION_FLOAT or PRECISION_MIXED and stencil a 5-point one
+ * @return the difference between the sums of the two last sweeps
+ */
+double calculateFloatGrid(diff_func function, FloatGrid *grid, const source_point *sources, size_t num_sources,
+                          double terminate, unsigned int n_iter, int is_cyclic, const SolverOptions *options);
+
+/**
+ * Same as calculateFloatGrid() but returns an error instead of printing it and exiting.
+ * @param function function that calculate the temperature of a coordinate
+ * @param grid the grid
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param options how to sweep, precision is PRECISION_FLOAT or PRECISION_MIXED
+ * @param delta set to the difference between the sums of the two last sweeps
+ * @return HEAT_OK, HEAT_ERROR_MEMORY or HEAT_ERROR_PRECISION (the stencil reads the diagonals)
+ */
+int tryCalculateFloatGrid(diff_func function, FloatGrid *grid, const source_point *sources, size_t num_sources,
+                          double terminate, unsigned int n_iter, int is_cyclic, const SolverOptions *options,
+                          double *delta);
+
+/**
+ * tell if the options can be used together, and report the ones which can't on stderr
+ * @param options the options, read from the environment and the command line
+ * @return 0 if they can and 1 if not
+ */
+int checkOptions(const SolverOptions *options);
+
+/**
+ * set the default options
+ * @param options the options
+ */
+void defaultOptions(SolverOptions *options);
+
+/**
+ * read the options from the HEAT_* environment variables
+ * @param options the options
+ * @return 0 if it's work and 1 if a variable has a bad value
+ */
+int readOptionsFromEnv(SolverOptions *options);
+
+/**
+ * read the --name=value options at the start of the command line
+ * @param options the options
+ * @param argc number of arguments
+ * @param argv the arguments
+ * @param first set to the index of the first argument which is not an option
+ * @return 0 if it's work and 1 if an option is unknown or has a bad value
+ */
+int readOptionsFromArgs(SolverOptions *options, int argc, char *argv[], int *first);
+
+#endif //SOLVER_H
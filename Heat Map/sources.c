@@ -0,0 +1,181 @@
+/**
+ * @file sources.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief index of the heat sources by line of the grid
+ */
+
+// ------------------------------ includes --------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include "sources.h"
+
+// ------------------------------ functions -------------------------------
+/**
+ * compare two positions for qsort
+ * @param a first position
+ * @param b second position
+ * @return negative, 0 or positive
+ */
+static int comparePos(const void *a, const void *b)
+{
+    int first = *(const int *) a, second = *(const int *) b;
+    return (first > second) - (first < second);
+}
+
+/**
+ * build the index of the sources
+ * sources out of the grid are ignored, the same point given twice is kept once
+ * @param index the index
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param byColumn SOURCES_BY_ROW to group by x, SOURCES_BY_COLUMN to group by y
+ * @return 0 if it's work and 1 if not
+ */
+int buildSourceIndex(SourceIndex *index, const source_point *sources, size_t num_sources, size_t n, size_t m,
+                     int byColumn)
+{
+    index->start = NULL;
+    index->pos = NULL;
+    index->startCapacity = 0;
+    index->posCapacity = 0;
+    return rebuildSourceIndex(index, sources, num_sources, n, m, byColumn);
+}
+
+/**
+ * build the index of the sources again, in the memory of the index if it is large enough
+ * The sources are counted by line, then each line is filled from its start, which moves start[k] to the start of the
+ * next line: start is shifted back by one line afterwards, so no other array is needed.
+ * @param index an index from buildSourceIndex or rebuildSourceIndex, or one set to 0
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param byColumn SOURCES_BY_ROW to group by x, SOURCES_BY_COLUMN to group by y
+ * @return 0 if it's work and 1 if not, the index is then freed
+ */
+int rebuildSourceIndex(SourceIndex *index, const source_point *sources, size_t num_sources, size_t n, size_t m,
+                       int byColumn)
+{
+    size_t lines = byColumn ? m : n, length = byColumn ? n : m;
+
+    if (index->start == NULL || index->startCapacity < lines)
+    {
+        free(index->start);
+        index->start = (size_t *) malloc(sizeof(size_t) * (lines + 1));
+        index->startCapacity = lines;
+    }
+    if (index->pos == NULL || index->posCapacity < num_sources)
+    {
+        free(index->pos);
+        index->pos = (int *) malloc(sizeof(int) * (num_sources + 1));
+        index->posCapacity = num_sources;
+    }
+    index->lines = lines;
+    if (index->start == NULL || index->pos == NULL)
+    {
+        freeSourceIndex(index);
+        return 1;
+    }
+    memset(index->start, 0, sizeof(size_t) * (lines + 1));
+    for (size_t i = 0; i < num_sources; ++i)
+    { // count the sources of each line
+        int line = byColumn ? sources[i].y : sources[i].x, pos = byColumn ? sources[i].x : sources[i].y;
+        if (line >= 0 && pos >= 0 && (size_t) line < lines && (size_t) pos < length)
+        {
+            index->start[line + 1]++;
+        }
+    }
+    for (size_t k = 0; k < lines; ++k)
+    {
+        index->start[k + 1] += index->start[k];
+    }
+    for (size_t i = 0; i < num_sources; ++i)
+    {
+        int line = byColumn ? sources[i].y : sources[i].x, pos = byColumn ? sources[i].x : sources[i].y;
+        if (line >= 0 && pos >= 0 && (size_t) line < lines && (size_t) pos < length)
+        {
+            index->pos[index->start[line]++] = pos;
+        }
+    }
+    for (size_t k = lines; k > 0; --k)
+    {
+        index->start[k] = index->start[k - 1];
+    }
+    index->start[0] = 0;
+    size_t kept = 0;
+    for (size_t k = 0; k < lines; ++k)
+    { // sort each line and drop duplicates, compacting in place
+        size_t begin = index->start[k], end = index->start[k + 1];
+        qsort(index->pos + begin, end - begin, sizeof(int), comparePos);
+        index->start[k] = kept;
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (i == begin || index->pos[i] != index->pos[i - 1])
+            {
+                index->pos[kept++] = index->pos[i];
+            }
+        }
+    }
+    index->start[lines] = kept;
+    return 0;
+}
+
+/**
+ * free the index
+ * @param index the index
+ */
+void freeSourceIndex(SourceIndex *index)
+{
+    free(index->start);
+    free(index->pos);
+    index->start = NULL;
+    index->pos = NULL;
+    index->startCapacity = 0;
+    index->posCapacity = 0;
+}
+
+/**
+ * find the points whose source changed between two lists of sources on the same grid
+ * The new sources are indexed by row, so an old source is looked up in its row instead of in the whole list.
+ * @param previous the grid the old sources were on, before the new sources are put on it
+ * @param old list of the old sources
+ * @param num_old number of old sources
+ * @param sources list of the new sources
+ * @param num_sources number of new sources
+ * @param changes room for num_old + num_sources points, set to the points which changed and their new values
+ * @param num_changes set to the number of changes
+ * @return 0 if it's work and 1 if not
+ */
+int findSourceChanges(const Grid *previous, const source_point *old, size_t num_old, const source_point *sources,
+                      size_t num_sources, source_point *changes, size_t *num_changes)
+{
+    SourceIndex index;
+    size_t count = 0;
+    if (buildSourceIndex(&index, sources, num_sources, previous->n, previous->m, SOURCES_BY_ROW))
+    {
+        return 1;
+    }
+    for (size_t i = 0; i < num_sources; ++i)
+    {
+        if (GRID_AT(previous, sources[i].x, sources[i].y) != sources[i].value)
+        { // added, or with another value
+            changes[count++] = sources[i];
+        }
+    }
+    for (size_t i = 0; i < num_old; ++i)
+    {
+        size_t begin = index.start[old[i].x], end = index.start[old[i].x + 1];
+        if (bsearch(&old[i].y, index.pos + begin, end - begin, sizeof(int), comparePos) == NULL)
+        { // removed, the point is free from now on
+            changes[count] = old[i];
+            changes[count++].value = GRID_AT(previous, old[i].x, old[i].y);
+        }
+    }
+    freeSourceIndex(&index);
+    *num_changes = count;
+    return 0;
+}
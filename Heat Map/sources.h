@@ -0,0 +1,83 @@
+/**
+ * @file sources.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief index of the heat sources by line of the grid
+ */
+#ifndef SOURCES_H
+#define SOURCES_H
+
+// ------------------------------ includes --------------------------------
+#include <stddef.h>
+#include "calculator.h"
+#include "grid.h"
+
+// -------------------------- const definitions -------------------------
+#define SOURCES_BY_ROW 0
+#define SOURCES_BY_COLUMN 1
+
+/**
+ * The sources grouped by line (row or column of the grid), in CSR form: the sources on line k are at positions
+ * pos[start[k]] .. pos[start[k + 1] - 1], sorted and without duplicates. A sweep walks a line as runs of free cells
+ * between two consecutive positions instead of searching the source list for every cell.
+ * start has room for startCapacity lines + 1 and pos for posCapacity positions, rebuildSourceIndex reuses them.
+ */
+typedef struct SourceIndex
+{
+    size_t *start;
+    int *pos;
+    size_t lines;
+    size_t startCapacity;
+    size_t posCapacity;
+} SourceIndex;
+
+// ------------------------------ functions -------------------------------
+/**
+ * build the index of the sources
+ * @param index the index
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param byColumn SOURCES_BY_ROW to group by x, SOURCES_BY_COLUMN to group by y
+ * @return 0 if it's work and 1 if not
+ */
+int buildSourceIndex(SourceIndex *index, const source_point *sources, size_t num_sources, size_t n, size_t m,
+                     int byColumn);
+
+/**
+ * build the index of the sources again, in the memory of the index if it is large enough
+ * @param index an index from buildSourceIndex or rebuildSourceIndex, or one set to 0
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param byColumn SOURCES_BY_ROW to group by x, SOURCES_BY_COLUMN to group by y
+ * @return 0 if it's work and 1 if not, the index is then freed
+ */
+int rebuildSourceIndex(SourceIndex *index, const source_point *sources, size_t num_sources, size_t n, size_t m,
+                       int byColumn);
+
+/**
+ * free the index
+ * @param index the index
+ */
+void freeSourceIndex(SourceIndex *index);
+
+/**
+ * find the points whose source changed between two lists of sources on the same grid: the new sources whose value is
+ * not the one of the point in previous (added or changed), and the old sources which are not sources any more
+ * @param previous the grid the old sources were on, before the new sources are put on it
+ * @param old list of the old sources
+ * @param num_old number of old sources
+ * @param sources list of the new sources
+ * @param num_sources number of new sources
+ * @param changes room for num_old + num_sources points, set to the points which changed and their new values
+ * @param num_changes set to the number of changes
+ * @return 0 if it's work and 1 if not
+ */
+int findSourceChanges(const Grid *previous, const source_point *old, size_t num_old, const source_point *sources,
+                      size_t num_sources, source_point *changes, size_t *num_changes);
+
+#endif //SOURCES_H
@@ -0,0 +1,42 @@
+/**
+ * @file status.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief the errors returned by the functions which don't exit
+ */
+
+// ------------------------------ includes --------------------------------
+#include <stddef.h>
+#include "status.h"
+
+// -------------------------- const definitions -------------------------
+static const char *const MESSAGES[] = {
+        "",
+        "Memory allocation failed.",
+        "Error opening the input.",
+        "Error with file format: grid size.",
+        "Error with file format: source point.",
+        "Segmentation fault",
+        "Error with file format: termination value.",
+        "Error with file format: n_iter.",
+        "Error with file format: is_cyclic.",
+        "The nine-point stencil needs a grid with a ghost layer.",
+        "No input to solve.",
+        "The calculation was stopped.",
+        "Error with the grid to start from: not a grid of the size of the input.",
+        "The nine-point stencil needs the double precision.",
+};
+
+#define NUM_MESSAGES (sizeof(MESSAGES) / sizeof(MESSAGES[0]))
+
+// ------------------------------ functions -------------------------------
+/**
+ * the message of an error, the one ex3 prints on stderr before it exits
+ * @param status HEAT_OK or one of the HEAT_ERROR_* errors
+ * @return the message, without end of line
+ */
+const char *statusMessage(int status)
+{
+    return status >= 0 && (size_t) status < NUM_MESSAGES ? MESSAGES[status] : "Unknown error.";
+}
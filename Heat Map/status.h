@@ -0,0 +1,35 @@
+/**
+ * @file status.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief the errors returned by the functions which don't exit
+ */
+#ifndef STATUS_H
+#define STATUS_H
+
+// -------------------------- const definitions -------------------------
+#define HEAT_OK 0
+#define HEAT_ERROR_MEMORY 1
+#define HEAT_ERROR_FILE 2
+#define HEAT_ERROR_SIZE 3
+#define HEAT_ERROR_SOURCE 4
+#define HEAT_ERROR_OUT_OF_RANGE 5
+#define HEAT_ERROR_TERMINATE 6
+#define HEAT_ERROR_N_ITER 7
+#define HEAT_ERROR_CYCLIC 8
+#define HEAT_ERROR_HALO 9
+#define HEAT_ERROR_NO_INPUT 10
+#define HEAT_ERROR_STOPPED 11
+#define HEAT_ERROR_WARM_START 12
+#define HEAT_ERROR_PRECISION 13
+
+// ------------------------------ functions -------------------------------
+/**
+ * the message of an error, the one ex3 prints on stderr before it exits
+ * @param status HEAT_OK or one of the HEAT_ERROR_* errors
+ * @return the message, without end of line
+ */
+const char *statusMessage(int status);
+
+#endif //STATUS_H
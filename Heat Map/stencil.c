@@ -0,0 +1,165 @@
+/**
+ * @file stencil.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief built-in heat functions, with a sweep kernel specialised for each of them
+ */
+
+// ------------------------------ includes --------------------------------
+#include "stencil.h"
+#include "solver.h"
+
+// -------------------------- const definitions -------------------------
+/**
+ * the new value of *cell for each stencil, cell[1], cell[-stride], cell[-1] and cell[stride] being the right, top,
+ * left and bottom neighbours. The 5-point formulas add the neighbours in the order of their function, so the kernels
+ * and the functions give the same values.
+ */
+#define AVERAGE_FORMULA ((cell[1] + cell[-stride] + cell[-1] + cell[stride]) * 0.25)
+#define WEIGHTED_FORMULA (*cell * 0.5 + (cell[1] + cell[-stride] + cell[-1] + cell[stride]) * 0.125)
+#define NINE_POINT_FORMULA (((cell[1] + cell[-stride] + cell[-1] + cell[stride]) * 4 + \
+                             (cell[-stride + 1] + cell[-stride - 1] + cell[stride - 1] + cell[stride + 1])) * 0.05)
+
+/**
+ * define a sweep kernel (see StencilRun) with the formula inlined in its loop
+ * @param name name of the kernel
+ * @param formula the new value of *cell
+ */
+#define STENCIL_RUN(name, formula) \
+static double name(diff_func function, double *cell, ptrdiff_t stride, ptrdiff_t step, int count, double sum) \
+{ \
+    (void) function; \
+    for (int i = 0; i < count; ++i, cell += step) \
+    { \
+        *cell = (formula); \
+        sum += *cell; \
+    } \
+    return sum; \
+}
+
+/**
+ * define an over-relaxed sweep kernel (see StencilRelax) with the formula inlined in its loop
+ * @param name name of the kernel
+ * @param formula the new value of *cell without over-relaxation
+ */
+#define STENCIL_RELAX(name, formula) \
+static double name(diff_func function, double *cell, ptrdiff_t stride, ptrdiff_t step, int count, double omega, \
+                   double sum) \
+{ \
+    (void) function; \
+    for (int i = 0; i < count; ++i, cell += step) \
+    { \
+        *cell += omega * ((formula) - *cell); \
+        sum += *cell; \
+    } \
+    return sum; \
+}
+
+// ------------------------------ functions -------------------------------
+/**
+ * the average of the four neighbours of a point
+ * the vectorised kernels add the neighbours in the same order, so they give the same values
+ * @param current the point (unused)
+ * @param right right neighbour
+ * @param top top neighbour
+ * @param left left neighbour
+ * @param bottom bottom neighbour
+ * @return the new value of the point
+ */
+double averageStencil(double current, double right, double top, double left, double bottom)
+{
+    (void) current;
+    return (right + top + left + bottom) * 0.25;
+}
+
+/**
+ * half of the point and half of the average of its four neighbours
+ * @param current the point
+ * @param right right neighbour
+ * @param top top neighbour
+ * @param left left neighbour
+ * @param bottom bottom neighbour
+ * @return the new value of the point
+ */
+double weightedStencil(double current, double right, double top, double left, double bottom)
+{
+    return current * 0.5 + (right + top + left + bottom) * 0.125;
+}
+
+/**
+ * the generic kernel: call the heat function for each point
+ * @param function heat function
+ * @param cell the first point of the run
+ * @param stride distance between two rows
+ * @param step distance between two points of the run
+ * @param count number of points
+ * @param sum the sum so far
+ * @return the sum with the points of the run added
+ */
+static double functionRun(diff_func function, double *cell, ptrdiff_t stride, ptrdiff_t step, int count, double sum)
+{
+    for (int i = 0; i < count; ++i, cell += step)
+    {
+        *cell = function(*cell, cell[1], cell[-stride], cell[-1], cell[stride]);
+        sum += *cell;
+    }
+    return sum;
+}
+
+/**
+ * the generic over-relaxed kernel: call the heat function for each point
+ * @param function heat function
+ * @param cell the first point of the run
+ * @param stride distance between two rows
+ * @param step distance between two points of the run
+ * @param count number of points
+ * @param omega the over-relaxation factor
+ * @param sum the sum so far
+ * @return the sum with the points of the run added
+ */
+static double functionRelax(diff_func function, double *cell, ptrdiff_t stride, ptrdiff_t step, int count,
+                            double omega, double sum)
+{
+    for (int i = 0; i < count; ++i, cell += step)
+    {
+        *cell += omega * (function(*cell, cell[1], cell[-stride], cell[-1], cell[stride]) - *cell);
+        sum += *cell;
+    }
+    return sum;
+}
+
+STENCIL_RUN(averageRun, AVERAGE_FORMULA)
+
+STENCIL_RUN(weightedRun, WEIGHTED_FORMULA)
+
+STENCIL_RUN(ninePointRun, NINE_POINT_FORMULA)
+
+STENCIL_RELAX(averageRelax, AVERAGE_FORMULA)
+
+STENCIL_RELAX(weightedRelax, WEIGHTED_FORMULA)
+
+STENCIL_RELAX(ninePointRelax, NINE_POINT_FORMULA)
+
+static const Stencil STENCILS[] = {
+        {NULL, functionRun, functionRelax, 0},
+        {averageStencil, averageRun, averageRelax, 0},
+        {weightedStencil, weightedRun, weightedRelax, 0},
+        {NULL, ninePointRun, ninePointRelax, 1},
+};
+
+#define NUM_STENCILS (sizeof(STENCILS) / sizeof(STENCILS[0]))
+
+/**
+ * find a built-in stencil
+ * @param stencil STENCIL_*, an unknown value gives the generic one
+ * @return the stencil
+ */
+const Stencil *findStencil(int stencil)
+{
+    if (stencil < 0 || (size_t) stencil >= NUM_STENCILS)
+    {
+        stencil = STENCIL_FUNCTION;
+    }
+    return &STENCILS[stencil];
+}
@@ -0,0 +1,89 @@
+/**
+ * @file stencil.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief built-in heat functions, with a sweep kernel specialised for each of them
+ */
+#ifndef STENCIL_H
+#define STENCIL_H
+
+// ------------------------------ includes --------------------------------
+#include <stddef.h>
+#include "calculator.h"
+
+/**
+ * calculate a run of points which are not sources, reading the neighbours without checking the boundary
+ * @param function heat function, only called by the generic kernel
+ * @param cell the first point of the run
+ * @param stride distance between two rows
+ * @param step distance between two points of the run
+ * @param count number of points
+ * @param sum the sum so far
+ * @return the sum with the points of the run added
+ */
+typedef double (*StencilRun)(diff_func function, double *cell, ptrdiff_t stride, ptrdiff_t step, int count,
+                             double sum);
+
+/**
+ * calculate a run of points like StencilRun, each point moved omega times as far as the stencil moves it (successive
+ * over-relaxation)
+ * @param function heat function, only called by the generic kernel
+ * @param cell the first point of the run
+ * @param stride distance between two rows
+ * @param step distance between two points of the run
+ * @param count number of points
+ * @param omega the over-relaxation factor
+ * @param sum the sum so far
+ * @return the sum with the points of the run added
+ */
+typedef double (*StencilRelax)(diff_func function, double *cell, ptrdiff_t stride, ptrdiff_t step, int count,
+                               double omega, double sum);
+
+/**
+ * A built-in stencil (STENCIL_* in solver.h).
+ * function calculates one point from its four neighbours, for the sweeps which check the boundary and the red-black
+ * order. It is NULL when the stencil also reads the four diagonal neighbours (diagonals == 1): such a stencil can't
+ * be a diff_func and is only swept with run, on a grid with a ghost layer.
+ * run is the sweep kernel with the stencil inlined, generic for STENCIL_FUNCTION (it calls the function of the call),
+ * relax is the same kernel with over-relaxation.
+ */
+typedef struct Stencil
+{
+    diff_func function;
+    StencilRun run;
+    StencilRelax relax;
+    int diagonals;
+} Stencil;
+
+// ------------------------------ functions -------------------------------
+/**
+ * the average of the four neighbours of a point
+ * @param current the point (unused)
+ * @param right right neighbour
+ * @param top top neighbour
+ * @param left left neighbour
+ * @param bottom bottom neighbour
+ * @return the new value of the point
+ */
+double averageStencil(double current, double right, double top, double left, double bottom);
+
+/**
+ * half of the point and half of the average of its four neighbours
+ * @param current the point
+ * @param right right neighbour
+ * @param top top neighbour
+ * @param left left neighbour
+ * @param bottom bottom neighbour
+ * @return the new value of the point
+ */
+double weightedStencil(double current, double right, double top, double left, double bottom);
+
+/**
+ * find a built-in stencil
+ * @param stencil STENCIL_*, an unknown value gives the generic one
+ * @return the stencil
+ */
+const Stencil *findStencil(int stencil);
+
+#endif //STENCIL_H
@@ -0,0 +1,59 @@
+/**
+ * @file sum.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief accurate sums of the points of a grid, in an order which doesn't depend on the threads
+ */
+
+// ------------------------------ includes --------------------------------
+#include "sum.h"
+
+// -------------------------- const definitions -------------------------
+#define PAIRWISE_BLOCK 32
+#define SUM_LANES 4
+
+// ------------------------------ functions -------------------------------
+/**
+ * sum values pairwise, a block of at most PAIRWISE_BLOCK values in four interleaved partial sums
+ * @param values the values
+ * @param count number of values
+ * @return the sum
+ */
+double pairwiseSum(const double *values, size_t count)
+{
+    if (count > PAIRWISE_BLOCK)
+    {
+        size_t half = count / 2;
+        return pairwiseSum(values, half) + pairwiseSum(values + half, count - half);
+    }
+    double partial[SUM_LANES] = {0};
+    size_t i = 0;
+    for (; i + SUM_LANES <= count; i += SUM_LANES)
+    {
+        for (int j = 0; j < SUM_LANES; ++j)
+        {
+            partial[j] += values[i + j];
+        }
+    }
+    for (; i < count; ++i)
+    {
+        partial[0] += values[i];
+    }
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+}
+
+/**
+ * sum the points of a grid: each row pairwise into rowSums, then rowSums pairwise
+ * @param grid the grid
+ * @param rowSums room for n sums, set to the sum of each row
+ * @return the sum of the points on the grid
+ */
+double sumGrid(const Grid *grid, double *rowSums)
+{
+    for (size_t x = 0; x < grid->n; ++x)
+    {
+        rowSums[x] = pairwiseSum(GRID_ROW(grid, x), grid->m);
+    }
+    return pairwiseSum(rowSums, grid->n);
+}
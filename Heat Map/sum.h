@@ -0,0 +1,33 @@
+/**
+ * @file sum.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief accurate sums of the points of a grid, in an order which doesn't depend on the threads
+ */
+#ifndef SUM_H
+#define SUM_H
+
+// ------------------------------ includes --------------------------------
+#include <stddef.h>
+#include "grid.h"
+
+// ------------------------------ functions -------------------------------
+/**
+ * sum values pairwise: the two halves are summed apart and added, down to blocks of a few values. The error grows
+ * with the log of count instead of count, and the order of the additions only depends on count.
+ * @param values the values
+ * @param count number of values
+ * @return the sum
+ */
+double pairwiseSum(const double *values, size_t count);
+
+/**
+ * sum the points of a grid: each row pairwise into rowSums, then rowSums pairwise
+ * @param grid the grid
+ * @param rowSums room for n sums, set to the sum of each row
+ * @return the sum of the points on the grid
+ */
+double sumGrid(const Grid *grid, double *rowSums);
+
+#endif //SUM_H
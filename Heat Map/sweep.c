@@ -0,0 +1,862 @@
+/**
+ * @file sweep.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief one sweep of the calculator over the grid, in the different traversal orders
+ */
+#define _GNU_SOURCE
+
+// ------------------------------ includes --------------------------------
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "profile.h"
+#include "solver.h"
+#include "sweep.h"
+
+// -------------------------- const definitions -------------------------
+#define DEFAULT_L1 (32 * 1024)
+#define DEFAULT_L2 (1024 * 1024)
+#define L1_ROWS 4
+#define MIN_TILE 8
+#define MIN_BLOCK_COLS 64
+#define ACTIVE_TILE 32
+#define PI 3.14159265358979323846
+#define STREAM_BAND (16 * 1024 * 1024)
+
+// ------------------------------ functions -------------------------------
+/**
+ * find the neighbour of (x,y) if it's cyclic
+ * @param grid the grid
+ * @param right right neighbour
+ * @param top top neighbour
+ * @param left left neighbour
+ * @param bottom bottom neighbour
+ * @param x x coordinate
+ * @param y y coordinate
+ * @param n width
+ * @param m length
+ */
+void cyclic(const Grid *grid, double *right, double *top, double *left, double *bottom, int x, int y, int n, int m)
+{
+    if (x == 0)
+    {
+        *top = GRID_AT(grid, n - 1, y);
+    }
+    else
+    {
+        *top = GRID_AT(grid, x - 1, y);
+    }
+    if (y == 0)
+    {
+        *left = GRID_AT(grid, x, m - 1);
+    }
+    else
+    {
+        *left = GRID_AT(grid, x, y - 1);
+    }
+    if (x == n - 1)
+    {
+        *bottom = GRID_AT(grid, 0, y);
+    }
+    else
+    {
+        *bottom = GRID_AT(grid, x + 1, y);
+    }
+    if (y == m - 1)
+    {
+        *right = GRID_AT(grid, x, 0);
+    }
+    else
+    {
+        *right = GRID_AT(grid, x, y + 1);
+    }
+}
+
+/**
+ * find the neighbour of (x,y) if it's cyclic
+ * @param grid the grid
+ * @param right right neighbour
+ * @param top top neighbour
+ * @param left left neighbour
+ * @param bottom bottom neighbour
+ * @param x x coordinate
+ * @param y y coordinate
+ * @param n width
+ * @param m length
+ */
+void notCyclic(const Grid *grid, double *right, double *top, double *left, double *bottom, int x, int y, int n, int m)
+{
+    if (x == 0)
+    {
+        *top = 0;
+    }
+    else
+    {
+        *top = GRID_AT(grid, x - 1, y);
+    }
+    if (y == 0)
+    {
+        *left = 0;
+    }
+    else
+    {
+        *left = GRID_AT(grid, x, y - 1);
+    }
+    if (x == n - 1)
+    {
+        *bottom = 0;
+    }
+    else
+    {
+        *bottom = GRID_AT(grid, x + 1, y);
+    }
+    if (y == m - 1)
+    {
+        *right = 0;
+    }
+    else
+    {
+        *right = GRID_AT(grid, x, y + 1);
+    }
+
+}
+
+/**
+ * calculate the new heat of one point which is not a source
+ * @param function heat function
+ * @param grid the grid
+ * @param x x coordinate
+ * @param y y coordinate
+ * @param n width
+ * @param m length
+ * @param is_cyclic
+ */
+static void updateCell(diff_func function, Grid *grid, int x, int y, int n, int m, int is_cyclic)
+{
+    double right, top, left, bottom;
+    if (!is_cyclic)
+    {
+        notCyclic(grid, &right, &top, &left, &bottom, x, y, n, m);
+    }
+    else
+    { // if it's cyclic
+        cyclic(grid, &right, &top, &left, &bottom, x, y, n, m);
+    }
+    GRID_AT(grid, x, y) = function(GRID_AT(grid, x, y), right, top, left, bottom);
+}
+
+/**
+ * calculate the new heat of one point which is not a source, moved omega times as far as the heat function moves it
+ * @param state the sweep
+ * @param x x coordinate
+ * @param y y coordinate
+ */
+static void relaxCell(const SweepState *state, int x, int y)
+{
+    Grid *grid = state->grid;
+    double old = GRID_AT(grid, x, y);
+    updateCell(state->function, grid, x, y, (int) grid->n, (int) grid->m, state->is_cyclic);
+    GRID_AT(grid, x, y) = old + state->omega * (GRID_AT(grid, x, y) - old);
+}
+
+/**
+ * calculate for each points on the grid the new heat, column by column
+ * each column is walked as runs of free points between two sources, the sources themselves are only summed
+ * @param state the sweep, with the sources grouped by column
+ * @return the sum of the points on the grid
+ */
+double calculateOne(SweepState *state)
+{
+    diff_func function = state->function;
+    Grid *grid = state->grid;
+    int n = (int) grid->n, m = (int) grid->m, is_cyclic = state->is_cyclic, relax = state->omega != 1;
+    double sum = 0;
+    for (int y = 0; y < m; ++y)
+    {
+        const int *source = state->index.pos + state->index.start[y];
+        const int *lastSource = state->index.pos + state->index.start[y + 1];
+        int x = 0;
+        while (x < n)
+        {
+            int stop = source < lastSource ? *source : n;
+            for (; x < stop; ++x)
+            { // calculate the points up to the next source
+                if (relax)
+                {
+                    relaxCell(state, x, y);
+                }
+                else
+                {
+                    updateCell(function, grid, x, y, n, m, is_cyclic);
+                }
+                sum += GRID_AT(grid, x, y);
+            }
+            if (x < n)
+            { // the source keeps its value
+                sum += GRID_AT(grid, x, y);
+                ++x;
+                ++source;
+            }
+        }
+    }
+    return sum;
+}
+
+/**
+ * calculate the points from..to-1 of a column, skipping the sources
+ * @param state the sweep, with a grid with a ghost layer
+ * @param y the column
+ * @param from first point
+ * @param to after the last point
+ * @param source next source of the column, moved after the last source of the range
+ * @param lastSource after the last source of the column
+ * @param sum the sum so far
+ * @return the sum with the points of the range added
+ */
+static double sweepColumn(const SweepState *state, int y, int from, int to, const int **source,
+                          const int *lastSource, double sum)
+{
+    const Grid *grid = state->grid;
+    ptrdiff_t stride = (ptrdiff_t) grid->stride;
+    double *column = grid->data + y;
+    int x = from;
+    while (x < to)
+    {
+        int stop = *source < lastSource && **source < to ? **source : to;
+        if (state->omega != 1)
+        {
+            sum = state->relax(state->function, column + x * stride, stride, stride, stop - x, state->omega, sum);
+        }
+        else
+        {
+            sum = state->run(state->function, column + x * stride, stride, stride, stop - x, sum);
+        }
+        x = stop;
+        if (x < to)
+        { // the source keeps its value
+            sum += column[x * stride];
+            ++x;
+            ++*source;
+        }
+    }
+    return sum;
+}
+
+/**
+ * calculate for each points on the grid the new heat, like calculateOne but the neighbours of the edges are read
+ * from the ghost layer so the points are calculated without any branch.
+ * The ghost layer is filled at the start of the sweep. In a cyclic grid the points of the first row and of the first
+ * column are already new when the last row and the last column read them, so their ghost copies are refreshed once
+ * they are calculated. The stencils reading the diagonals also read the ghost copy of the last row from the next
+ * column, and the corners from the last column, so these are refreshed too.
+ * @param state the sweep, with the sources grouped by column and a grid with a ghost layer
+ * @return the sum of the points on the grid
+ */
+double calculateOneHalo(SweepState *state)
+{
+    Grid *grid = state->grid;
+    int n = (int) grid->n, m = (int) grid->m, is_cyclic = state->is_cyclic;
+    double sum = 0;
+    fillHalo(grid, is_cyclic);
+    for (int y = 0; y < m; ++y)
+    {
+        const int *source = state->index.pos + state->index.start[y];
+        const int *lastSource = state->index.pos + state->index.start[y + 1];
+        if (!is_cyclic)
+        {
+            sum = sweepColumn(state, y, 0, n, &source, lastSource, sum);
+            continue;
+        }
+        sum = sweepColumn(state, y, 0, 1, &source, lastSource, sum);
+        GRID_AT(grid, n, y) = GRID_AT(grid, 0, y);
+        if (m > 1)
+        {
+            sum = sweepColumn(state, y, 1, n, &source, lastSource, sum);
+        }
+        for (int x = 0; m == 1 && x < n; ++x)
+        { // a single column is its own left and right ghost copy, the diagonals of the next point read it
+            if (x > 0)
+            {
+                sum = sweepColumn(state, y, x, x + 1, &source, lastSource, sum);
+            }
+            GRID_AT(grid, x, -1) = GRID_AT(grid, x, 0);
+            GRID_AT(grid, x, 1) = GRID_AT(grid, x, 0);
+            if (x == 0)
+            {
+                GRID_AT(grid, n, -1) = GRID_AT(grid, 0, 0);
+                GRID_AT(grid, n, 1) = GRID_AT(grid, 0, 0);
+            }
+        }
+        GRID_AT(grid, -1, y) = GRID_AT(grid, n - 1, y);
+        if (y == 0)
+        {
+            for (int x = -1; x <= n; ++x)
+            {
+                GRID_AT(grid, x, m) = GRID_AT(grid, x, 0);
+            }
+        }
+    }
+    return sum;
+}
+
+/**
+ * calculate the points from..to-1 of a row, skipping the sources
+ * @param state the sweep
+ * @param x the row
+ * @param from first point
+ * @param to after the last point
+ * @param source next source of the row, moved after the last source of the range
+ * @param lastSource after the last source of the row
+ * @param sum the sum so far
+ * @return the sum with the points of the range added
+ */
+static double sweepRow(const SweepState *state, int x, int from, int to, const int **source, const int *lastSource,
+                       double sum)
+{
+    Grid *grid = state->grid;
+    double *row = GRID_ROW(grid, x);
+    int y = from;
+    while (y < to)
+    {
+        int stop = *source < lastSource && **source < to ? **source : to;
+        if (state->halo && state->omega != 1)
+        {
+            sum = state->relax(state->function, row + y, (ptrdiff_t) grid->stride, 1, stop - y, state->omega, sum);
+            y = stop;
+        }
+        else if (state->halo)
+        {
+            sum = state->run(state->function, row + y, (ptrdiff_t) grid->stride, 1, stop - y, sum);
+            y = stop;
+        }
+        for (; y < stop; ++y)
+        {
+            if (state->omega != 1)
+            {
+                relaxCell(state, x, y);
+            }
+            else
+            {
+                updateCell(state->function, grid, x, y, (int) grid->n, (int) grid->m, state->is_cyclic);
+            }
+            sum += row[y];
+        }
+        if (y < to)
+        { // the source keeps its value
+            sum += row[y];
+            ++y;
+            ++*source;
+        }
+    }
+    return sum;
+}
+
+/**
+ * calculate for each points on the grid the new heat, tile by tile
+ * The tiles are taken row after row, and the points of a tile row after row, so a tile of the full grid is the
+ * row-major order. With a ghost layer the copies of the first row and of the first column are refreshed as soon as
+ * they are calculated, like in calculateOneHalo, so it is the same Gauss-Seidel order with or without it.
+ * When the grid is streamed, the ghost points of a band are filled just before it, the next band is read ahead
+ * while it is calculated and the band before it is released once it is done: the sweep reads and writes the file
+ * once, in order, and the same grid comes out.
+ * @param state the sweep, with the sources grouped by row
+ * @return the sum of the points on the grid
+ */
+double calculateOneTiled(SweepState *state)
+{
+    Grid *grid = state->grid;
+    const SourceIndex *index = &state->index;
+    int n = (int) grid->n, m = (int) grid->m, refresh = state->halo && state->is_cyclic;
+    int tileRows = (int) state->tileRows, tileCols = (int) state->tileCols;
+    double sum = 0;
+
+    if (state->halo && state->stream)
+    {
+        fillHaloEdges(grid, state->is_cyclic);
+    }
+    else if (state->halo)
+    {
+        fillHalo(grid, state->is_cyclic);
+    }
+    for (int x0 = 0; x0 < n; x0 += tileRows)
+    {
+        int x1 = x0 + tileRows < n ? x0 + tileRows : n;
+        if (state->stream)
+        {
+            adviseGridRows(grid, (size_t) x1, (size_t) (x1 + tileRows < n ? x1 + tileRows : n), GRID_PREFETCH);
+        }
+        if (state->halo && state->stream)
+        {
+            fillHaloRows(grid, x0, x1, state->is_cyclic);
+        }
+        for (int x = x0; x < x1; ++x)
+        {
+            state->cursor[x - x0] = index->pos + index->start[x];
+        }
+        for (int y0 = 0; y0 < m; y0 += tileCols)
+        {
+            int y1 = y0 + tileCols < m ? y0 + tileCols : m;
+            for (int x = x0; x < x1; ++x)
+            {
+                const int *lastSource = index->pos + index->start[x + 1];
+                if (refresh && y0 == 0)
+                {
+                    sum = sweepRow(state, x, 0, 1, &state->cursor[x - x0], lastSource, sum);
+                    GRID_AT(grid, x, m) = GRID_AT(grid, x, 0);
+                    sum = sweepRow(state, x, 1, y1, &state->cursor[x - x0], lastSource, sum);
+                }
+                else
+                {
+                    sum = sweepRow(state, x, y0, y1, &state->cursor[x - x0], lastSource, sum);
+                }
+                if (refresh && x == 0)
+                {
+                    memcpy(GRID_ROW(grid, n) + y0, GRID_ROW(grid, 0) + y0, sizeof(double) * (size_t) (y1 - y0));
+                }
+            }
+        }
+        if (state->stream && x0 > 0)
+        { // the band is still read by the first row of the next one, the band before it is not
+            adviseGridRows(grid, (size_t) (x0 - tileRows), (size_t) x0, GRID_RELEASE);
+        }
+    }
+    return sum;
+}
+
+/**
+ * tell if a tile of calculateOneActive may change: if it and its four neighbours didn't change the last time they
+ * were calculated, it reads the points it read the last time and would calculate the same points again
+ * @param active the tiles
+ * @param i row of the tile
+ * @param j column of the tile
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise, the tiles of the edges are then neighbours
+ * @return 1 if the tile has to be calculated and 0 if not
+ */
+static int tileActive(const ActiveTiles *active, int i, int j, int is_cyclic)
+{
+    int tilesX = (int) active->tilesX, tilesY = (int) active->tilesY;
+    int up = i > 0 ? i - 1 : is_cyclic ? tilesX - 1 : i, down = i + 1 < tilesX ? i + 1 : is_cyclic ? 0 : i;
+    int left = j > 0 ? j - 1 : is_cyclic ? tilesY - 1 : j, right = j + 1 < tilesY ? j + 1 : is_cyclic ? 0 : j;
+    const unsigned char *changed = active->changed;
+    return changed[i * tilesY + j] || changed[up * tilesY + j] || changed[down * tilesY + j] ||
+           changed[i * tilesY + left] || changed[i * tilesY + right];
+}
+
+/**
+ * calculate a tile of calculateOneActive, like calculateOneTiled does
+ * @param state the sweep
+ * @param x0 first row of the tile
+ * @param x1 after the last row of the tile
+ * @param y0 first column of the tile
+ * @param y1 after the last column of the tile
+ * @param sum set to the sum of the points of the tile
+ * @return 1 if a point changed by more than the threshold and 0 if not
+ */
+static int sweepActiveTile(SweepState *state, int x0, int x1, int y0, int y1, double *sum)
+{
+    Grid *grid = state->grid;
+    const SourceIndex *index = &state->index;
+    int n = (int) grid->n, m = (int) grid->m, refresh = state->halo && state->is_cyclic, changed = 0;
+    double threshold = state->active->threshold, *saved = state->active->saved;
+
+    *sum = 0;
+    for (int x = x0; x < x1; ++x)
+    {
+        double *row = GRID_ROW(grid, x);
+        const int *lastSource = index->pos + index->start[x + 1];
+        memcpy(saved, row + y0, sizeof(double) * (size_t) (y1 - y0));
+        if (refresh && y0 == 0)
+        {
+            *sum = sweepRow(state, x, 0, 1, &state->cursor[x - x0], lastSource, *sum);
+            GRID_AT(grid, x, m) = GRID_AT(grid, x, 0);
+            *sum = sweepRow(state, x, 1, y1, &state->cursor[x - x0], lastSource, *sum);
+        }
+        else
+        {
+            *sum = sweepRow(state, x, y0, y1, &state->cursor[x - x0], lastSource, *sum);
+        }
+        if (refresh && x == 0)
+        {
+            memcpy(GRID_ROW(grid, n) + y0, row + y0, sizeof(double) * (size_t) (y1 - y0));
+        }
+        for (int y = y0; y < y1 && !changed; ++y)
+        {
+            changed = row[y] - saved[y - y0] > threshold || saved[y - y0] - row[y] > threshold;
+        }
+    }
+    return changed;
+}
+
+/**
+ * calculate the new heat of the points of the tiles which may change, tile by tile like calculateOneTiled
+ * The flags of the tiles are updated in place, so when a tile is reached the tiles before it tell about this sweep
+ * and the tiles after it about the last one, which are the points the tile reads from them. A skipped tile keeps its
+ * points and adds the sum it had, so with a threshold of 0 the grid is the one of calculateOneTiled, and only the
+ * order of the sum changes. Above 0, the tiles whose points move by less than the threshold stop being calculated.
+ * @param state the sweep, with the sources grouped by row and active set up for its tiles
+ * @return the sum of the points on the grid
+ */
+double calculateOneActive(SweepState *state)
+{
+    Grid *grid = state->grid;
+    ActiveTiles *active = state->active;
+    const SourceIndex *index = &state->index;
+    int n = (int) grid->n, m = (int) grid->m;
+    int tileRows = (int) state->tileRows, tileCols = (int) state->tileCols, tilesY = (int) active->tilesY;
+    double sum = 0;
+
+    if (state->halo)
+    {
+        fillHalo(grid, state->is_cyclic);
+    }
+    for (int i = 0, x0 = 0; x0 < n; ++i, x0 += tileRows)
+    {
+        int x1 = x0 + tileRows < n ? x0 + tileRows : n;
+        for (int x = x0; x < x1; ++x)
+        {
+            state->cursor[x - x0] = index->pos + index->start[x];
+        }
+        for (int j = 0, y0 = 0; y0 < m; ++j, y0 += tileCols)
+        {
+            int y1 = y0 + tileCols < m ? y0 + tileCols : m;
+            if (tileActive(active, i, j, state->is_cyclic))
+            {
+                active->changed[i * tilesY + j] = (unsigned char) sweepActiveTile(state, x0, x1, y0, y1,
+                                                                                  &active->sums[i * tilesY + j]);
+            }
+            else
+            {
+                for (int x = x0; x < x1; ++x)
+                { // the sources of the tile are passed
+                    const int *lastSource = index->pos + index->start[x + 1];
+                    while (state->cursor[x - x0] < lastSource && *state->cursor[x - x0] < y1)
+                    {
+                        ++state->cursor[x - x0];
+                    }
+                }
+            }
+            sum += active->sums[i * tilesY + j];
+        }
+    }
+    return sum;
+}
+
+/**
+ * set up the tiles of calculateOneActive, all of them to be calculated by the first sweep
+ * @param active the tiles
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param tileRows number of rows of a tile
+ * @param tileCols number of columns of a tile
+ * @param threshold the largest change of a point which leaves its tile unchanged
+ * @return 0 if it's work and 1 if not
+ */
+int initActiveTiles(ActiveTiles *active, size_t n, size_t m, size_t tileRows, size_t tileCols, double threshold)
+{
+    active->threshold = threshold;
+    active->tilesX = (n + tileRows - 1) / tileRows;
+    active->tilesY = (m + tileCols - 1) / tileCols;
+    size_t tiles = active->tilesX * active->tilesY;
+    active->changed = (unsigned char *) malloc(tiles > 0 ? tiles : 1);
+    active->sums = (double *) calloc(tiles > 0 ? tiles : 1, sizeof(double));
+    active->saved = (double *) malloc(sizeof(double) * tileCols);
+    if (active->changed == NULL || active->sums == NULL || active->saved == NULL)
+    {
+        freeActiveTiles(active);
+        return 1;
+    }
+    memset(active->changed, 1, tiles);
+    return 0;
+}
+
+/**
+ * set up the tiles of calculateOneActive for a grid which had converged before some of its sources changed
+ * The tiles start unchanged with the sum of their points, except the tiles of the changes: calculateOneActive
+ * calculates them and the tiles around them, and goes further as long as the tiles move by more than the threshold.
+ * @param active tiles from initActiveTiles
+ * @param grid the grid
+ * @param changes the points whose source changed
+ * @param num_changes number of changes
+ * @param tileRows number of rows of a tile
+ * @param tileCols number of columns of a tile
+ */
+void seedActiveTiles(ActiveTiles *active, const Grid *grid, const source_point *changes, size_t num_changes,
+                     size_t tileRows, size_t tileCols)
+{
+    size_t tilesY = active->tilesY;
+    memset(active->changed, 0, active->tilesX * tilesY);
+    memset(active->sums, 0, sizeof(double) * active->tilesX * tilesY);
+    for (size_t x = 0; x < grid->n; ++x)
+    {
+        const double *row = GRID_ROW(grid, x);
+        double *sums = active->sums + x / tileRows * tilesY;
+        for (size_t j = 0, y0 = 0; y0 < grid->m; ++j, y0 += tileCols)
+        {
+            size_t y1 = y0 + tileCols < grid->m ? y0 + tileCols : grid->m;
+            for (size_t y = y0; y < y1; ++y)
+            {
+                sums[j] += row[y];
+            }
+        }
+    }
+    for (size_t i = 0; i < num_changes; ++i)
+    {
+        active->changed[(size_t) changes[i].x / tileRows * tilesY + (size_t) changes[i].y / tileCols] = 1;
+    }
+}
+
+/**
+ * free the tiles of calculateOneActive
+ * @param active the tiles
+ */
+void freeActiveTiles(ActiveTiles *active)
+{
+    free(active->changed);
+    free(active->sums);
+    free(active->saved);
+    active->changed = NULL;
+    active->sums = NULL;
+    active->saved = NULL;
+}
+
+/**
+ * do the next sweeps of a row-major sweep together, row by row: row x of sweep t is calculated at step x + 2t
+ * In the row order row x of sweep t reads rows x - 1 of sweep t and x + 1 of sweep t - 1, which were calculated
+ * one step before, while row x + 1 of sweep t is only calculated at the next step. So the grid ends the same as after
+ * the sweeps one by one, but the rows stay in the cache from one sweep to the next.
+ * When the rows are too long for the cache, the columns are cut in strips of blockCols, done one after the other, and
+ * sweep t of strip j calculates the columns j * blockCols - t to (j + 1) * blockCols - t (the strips lean one column
+ * left per sweep). Point (x, y) of sweep t reads (x, y - 1) of sweep t, calculated before it in the same row of the
+ * strip or in the strip before, and (x, y + 1) of sweep t - 1, calculated one column further right, so in the same
+ * strip or the one before, and not yet by sweep t. So the strips end with the same grid too. A sweep then sums each
+ * row in its order (rowSums) and adds up the rows in their order; on one strip it sums the points in the order of
+ * the rows, like calculateOneTiled does.
+ * @param state the sweep, with the sources grouped by row and a grid which is not cyclic
+ * @param sweeps number of sweeps
+ * @param sums set to the sum of the points after each sweep
+ * @param cursor room for the next source of each row of each sweep (n * sweeps)
+ * @param rowSums room for the sum of each row of each sweep (n * sweeps)
+ */
+static void sweepBlock(SweepState *state, int sweeps, double *sums, const int **cursor, double *rowSums)
+{
+    const SourceIndex *index = &state->index;
+    int n = (int) state->grid->n, m = (int) state->grid->m;
+    int cols = state->blockCols > 0 && state->blockCols < (size_t) m ? (int) state->blockCols : m;
+    int strips = cols < m ? (m + sweeps - 1 + cols - 1) / cols : 1;
+
+    for (int t = 0; t < sweeps; ++t)
+    {
+        sums[t] = 0;
+        for (int x = 0; x < n; ++x)
+        {
+            cursor[t * n + x] = index->pos + index->start[x];
+            rowSums[t * n + x] = 0;
+        }
+    }
+    for (int j = 0; j < strips; ++j)
+    {
+        for (int step = 0; step < n + 2 * (sweeps - 1); ++step)
+        {
+            for (int t = 0; t < sweeps; ++t)
+            {
+                int x = step - 2 * t, from = strips > 1 ? j * cols - t : 0, to = strips > 1 ? from + cols : m;
+                from = from > 0 ? from : 0;
+                to = to < m ? to : m;
+                if (x >= 0 && x < n && from < to)
+                {
+                    double *sum = strips > 1 ? &rowSums[t * n + x] : &sums[t];
+                    *sum = sweepRow(state, x, from, to, &cursor[t * n + x], index->pos + index->start[x + 1], *sum);
+                }
+            }
+        }
+    }
+    for (int t = 0; t < sweeps && strips > 1; ++t)
+    {
+        for (int x = 0; x < n; ++x)
+        {
+            sums[t] += rowSums[t * n + x];
+        }
+    }
+}
+
+/**
+ * do n_iter row-major sweeps, blockSweeps of them at a time (see sweepBlock)
+ * @param state the sweep, with the sources grouped by row and a grid which is not cyclic
+ * @param n_iter number of sweeps
+ * @param delta set to the difference between the sums of the two last sweeps
+ * @return 0 if it's work and 1 if not
+ */
+int calculateTemporal(SweepState *state, unsigned int n_iter, double *delta)
+{
+    int block = (int) state->blockSweeps;
+    ProfileMark mark;
+    size_t points = state->grid->n * (size_t) block;
+    double sum = 0, previousSum = 0;
+    double *sums = (double *) malloc(sizeof(double) * (size_t) block);
+    double *rowSums = (double *) malloc(sizeof(double) * (points > 0 ? points : 1));
+    const int **cursor = (const int **) malloc(sizeof(int *) * (points > 0 ? points : 1));
+    if (sums == NULL || rowSums == NULL || cursor == NULL)
+    {
+        free(sums);
+        free(rowSums);
+        free(cursor);
+        return 1;
+    }
+    if (state->halo)
+    { // the ghost layer stays 0, the sweeps never write it
+        fillHalo(state->grid, state->is_cyclic);
+    }
+    for (unsigned int done = 0; done < n_iter; done += (unsigned int) block)
+    {
+        int sweeps = n_iter - done < (unsigned int) block ? (int) (n_iter - done) : block;
+        if (profileLevel)
+        {
+            profileMark(&mark);
+        }
+        sweepBlock(state, sweeps, sums, cursor, rowSums);
+        for (int t = 0; t < sweeps; ++t)
+        {
+            previousSum = sum;
+            sum = sums[t];
+        }
+        if (profileLevel)
+        {
+            profileSweepBlock(&mark, (unsigned long) sweeps, sum - previousSum);
+        }
+    }
+    free(sums);
+    free(rowSums);
+    free(cursor);
+    *delta = sum - previousSum;
+    return 0;
+}
+
+/**
+ * read a cache size, or use a default one if the system doesn't tell
+ * @param name the sysconf name
+ * @param fallback the default size in bytes
+ * @return the size in bytes
+ */
+static size_t cacheSize(int name, size_t fallback)
+{
+    long size = sysconf(name);
+    return size > 0 ? (size_t) size : fallback;
+}
+
+/**
+ * choose the size of the tiles for the tiled order: a few rows of a tile fit in L1 (the row being calculated and its
+ * two neighbours), and the whole tile fits in half of L2
+ * @param tileRows number of rows of a tile, kept if not 0
+ * @param tileCols number of columns of a tile, kept if not 0
+ */
+void chooseTile(size_t *tileRows, size_t *tileCols)
+{
+    size_t l1 = cacheSize(_SC_LEVEL1_DCACHE_SIZE, DEFAULT_L1), l2 = cacheSize(_SC_LEVEL2_CACHE_SIZE, DEFAULT_L2);
+    if (*tileCols == 0)
+    {
+        *tileCols = l1 / (L1_ROWS * sizeof(double));
+    }
+    if (*tileRows == 0)
+    {
+        *tileRows = l2 / 2 / (*tileCols * sizeof(double));
+    }
+    if (*tileRows < MIN_TILE)
+    {
+        *tileRows = MIN_TILE;
+    }
+    if (*tileCols < MIN_TILE)
+    {
+        *tileCols = MIN_TILE;
+    }
+}
+
+/**
+ * choose the size of the tiles of calculateOneActive: small tiles, so the tiles far from the changes are skipped,
+ * but rows long enough for the kernels
+ * @param tileRows number of rows of a tile, kept if not 0
+ * @param tileCols number of columns of a tile, kept if not 0
+ */
+void chooseActiveTile(size_t *tileRows, size_t *tileCols)
+{
+    if (*tileRows == 0)
+    {
+        *tileRows = ACTIVE_TILE;
+    }
+    if (*tileCols == 0)
+    {
+        *tileCols = ACTIVE_TILE;
+    }
+}
+
+/**
+ * choose the over-relaxation factor of a grid, the optimal one for the average stencil
+ * The Jacobi sweep of the average stencil on a n*m grid with 0 around it has the spectral radius
+ * (cos(pi / (n + 1)) + cos(pi / (m + 1))) / 2, and the Gauss-Seidel sweep its square, so the optimal factor is
+ * 2 / (1 + sqrt(1 - rho^2)). A cyclic grid is only held by its sources, its slowest wave is the one along the longest
+ * edge, 1 + cos(2 pi / length) over 2. The weighted stencil keeps half of the point, (1 + rho) / 2.
+ * The other stencils are taken as the average one, which the nine-point one and the usual heat functions are close to.
+ * @param omega the factor, kept if it is not OMEGA_AUTO
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param stencil STENCIL_*
+ * @return the factor
+ */
+double chooseOmega(double omega, size_t n, size_t m, int is_cyclic, int stencil)
+{
+    double rho;
+    if (omega != OMEGA_AUTO)
+    {
+        return omega;
+    }
+    if (is_cyclic)
+    {
+        size_t length = n > m ? n : m;
+        rho = (1 + cos(2 * PI / (double) (length > 2 ? length : 2))) / 2;
+    }
+    else
+    {
+        rho = (cos(PI / (double) (n + 1)) + cos(PI / (double) (m + 1))) / 2;
+    }
+    if (stencil == STENCIL_WEIGHTED)
+    {
+        rho = (1 + rho) / 2;
+    }
+    return 2 / (1 + sqrt(1 - rho * rho));
+}
+
+/**
+ * choose the width of the strips of calculateTemporal: the points between the first and the last sweep of a block (two
+ * rows per sweep, a strip and the columns it leans by wide) fit in half of L2
+ * A stencil reading the diagonals also reads the point up and right of the last sweep, so it keeps full rows.
+ * @param blockCols set to the width of a strip, m for full rows
+ * @param blockSweeps number of sweeps of a block
+ * @param m length of the grid
+ * @param diagonals 1 if the stencil reads the diagonals and 0 if not
+ */
+void chooseBlockCols(size_t *blockCols, size_t blockSweeps, size_t m, int diagonals)
+{
+    size_t cols = cacheSize(_SC_LEVEL2_CACHE_SIZE, DEFAULT_L2) / 2 / (sizeof(double) * (2 * blockSweeps + 1));
+    cols = cols > blockSweeps + MIN_BLOCK_COLS ? cols - blockSweeps : MIN_BLOCK_COLS;
+    *blockCols = diagonals || cols > m ? m : cols;
+}
+
+/**
+ * choose the number of rows of the bands a mapped grid is streamed in: a band of STREAM_BAND bytes
+ * @param rows number of rows of a band, kept if not 0
+ * @param rowBytes size of a row of the grid in bytes
+ */
+void chooseStreamRows(size_t *rows, size_t rowBytes)
+{
+    if (*rows == 0)
+    {
+        *rows = STREAM_BAND / (rowBytes > 0 ? rowBytes : 1);
+    }
+    if (*rows == 0)
+    {
+        *rows = 1;
+    }
+}
@@ -0,0 +1,255 @@
+/**
+ * @file sweep.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief one sweep of the calculator over the grid, in the different traversal orders
+ */
+#ifndef SWEEP_H
+#define SWEEP_H
+
+// ------------------------------ includes --------------------------------
+#include "calculator.h"
+#include "grid.h"
+#include "pool.h"
+#include "sources.h"
+#include "stencil.h"
+
+// -------------------------- const definitions -------------------------
+#define RED 0
+#define BLACK 1
+
+/**
+ * The tiles of calculateOneActive: changed tells for each tile, row after row, if it changed by more than threshold
+ * the last time it was calculated, sums has the sum of its points then. saved has room for the points of a row of a
+ * tile.
+ */
+typedef struct ActiveTiles
+{
+    double threshold;
+    unsigned char *changed;
+    double *sums;
+    double *saved;
+    size_t tilesX;
+    size_t tilesY;
+} ActiveTiles;
+
+/**
+ * What a sweep needs, set up once by calculateGrid for all the sweeps of a call.
+ * index groups the sources by column for the column order and by row for the other orders, halo tells if the
+ * neighbours of the edges are read from the ghost layer, cursor has room for tileRows pointers. function is already
+ * the built-in one when stencil is not STENCIL_FUNCTION, run is the kernel of the stencil for the sweeps reading the
+ * ghost layer, simd is the widest instructions the kernels may use,
+ * blockSweeps is the number of sweeps calculateTemporal does together. firstRow is the number in the whole grid of
+ * the first row of grid, which gives the colours of the red-black order when grid is a band of it. active is the
+ * tiles of calculateOneActive, NULL for the other sweeps. omega is the over-relaxation factor, each point moves omega
+ * times as far as the heat function moves it: 1 is the Gauss-Seidel sweep, and the sweeps only call relax (the
+ * kernel of the stencil with over-relaxation) and the SIMD kernels are only used when it is 1, so the grid is the
+ * same as without it. rowSums is NULL, or room for the rows of the whole grid: the red-black sweeps then set the
+ * pairwise sum of each finished row (row firstRow + x of a band) and their sum is pairwiseSum of rowSums. stream tells
+ * that the grid is mapped from a file (see mapGrid): calculateOneTiled then takes its tiles of full rows as bands
+ * streamed through the mapping. blockCols is the width of the strips of calculateTemporal.
+ */
+typedef struct SweepState
+{
+    diff_func function;
+    StencilRun run;
+    StencilRelax relax;
+    double omega;
+    Grid *grid;
+    SourceIndex index;
+    int is_cyclic;
+    int halo;
+    size_t tileRows;
+    size_t tileCols;
+    const int **cursor;
+    int stencil;
+    int simd;
+    size_t blockSweeps;
+    size_t blockCols;
+    size_t firstRow;
+    ActiveTiles *active;
+    double *rowSums;
+    int stream;
+} SweepState;
+
+// ------------------------------ functions -------------------------------
+/**
+ * calculate for each points on the grid the new heat, column by column
+ * @param state the sweep, with the sources grouped by column
+ * @return the sum of the points on the grid
+ */
+double calculateOne(SweepState *state);
+
+/**
+ * calculate for each points on the grid the new heat, column by column, reading the edges from the ghost layer
+ * @param state the sweep, with the sources grouped by column and a grid with a ghost layer
+ * @return the sum of the points on the grid
+ */
+double calculateOneHalo(SweepState *state);
+
+/**
+ * calculate for each points on the grid the new heat, tile by tile
+ * @param state the sweep, with the sources grouped by row
+ * @return the sum of the points on the grid
+ */
+double calculateOneTiled(SweepState *state);
+
+/**
+ * calculate the new heat of the points of the tiles which may change, tile by tile like calculateOneTiled, the other
+ * tiles keep their points and their sum
+ * @param state the sweep, with the sources grouped by row and active set up for its tiles
+ * @return the sum of the points on the grid
+ */
+double calculateOneActive(SweepState *state);
+
+/**
+ * set up the tiles of calculateOneActive, all of them to be calculated by the first sweep
+ * @param active the tiles
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param tileRows number of rows of a tile
+ * @param tileCols number of columns of a tile
+ * @param threshold the largest change of a point which leaves its tile unchanged
+ * @return 0 if it's work and 1 if not
+ */
+int initActiveTiles(ActiveTiles *active, size_t n, size_t m, size_t tileRows, size_t tileCols, double threshold);
+
+/**
+ * set up the tiles of calculateOneActive for a grid which had converged before some of its sources changed: only the
+ * tiles of the changes are calculated by the first sweep, the other tiles keep their points until a change reaches them
+ * @param active tiles from initActiveTiles
+ * @param grid the grid
+ * @param changes the points whose source changed
+ * @param num_changes number of changes
+ * @param tileRows number of rows of a tile
+ * @param tileCols number of columns of a tile
+ */
+void seedActiveTiles(ActiveTiles *active, const Grid *grid, const source_point *changes, size_t num_changes,
+                     size_t tileRows, size_t tileCols);
+
+/**
+ * free the tiles of calculateOneActive
+ * @param active the tiles
+ */
+void freeActiveTiles(ActiveTiles *active);
+
+/**
+ * calculate for each points on the grid the new heat, the red points (x + y even) then the black ones
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @return the sum of the points on the grid
+ */
+double calculateOneRedBlack(SweepState *state);
+
+/**
+ * calculate the points of one colour of the rows from..to-1
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @param colour RED or BLACK
+ * @param from first row
+ * @param to after the last row
+ * @return the sum of the rows if the colour is BLACK and rowSums is NULL, 0 otherwise
+ */
+double redBlackPass(SweepState *state, int colour, int from, int to);
+
+/**
+ * calculate the grid with a red-black sweep split in bands of rows between the threads of the pool, until n_iter
+ * sweeps are done or the difference between the sums of two sweeps is below terminate (if n_iter is 0)
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @param pool the pool of the caller, started on the first call and kept, NULL to start one for this call only
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param threads number of threads
+ * @param delta set to the difference between the sums of the two last sweeps
+ * @param sweeps set to the number of sweeps done
+ * @return 0 if it's work and 1 if the pool can't be started
+ */
+int calculateParallel(SweepState *state, Pool **pool, double terminate, unsigned int n_iter, int threads,
+                      double *delta, unsigned long *sweeps);
+
+/**
+ * calculate the grid with a red-black sweep split in bands of rows between worker processes, each one pinned to a
+ * NUMA node and exchanging the edges of its band in shared memory, until n_iter sweeps are done or the difference
+ * between the sums of two sweeps is below terminate (if n_iter is 0)
+ * @param state the sweep, with the sources grouped by row and a grid with a ghost layer
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param n_iter number of iteration
+ * @param processes number of workers, 0 for one per NUMA node
+ * @param delta set to the difference between the sums of the two last sweeps
+ * @param sweeps set to the number of sweeps done
+ * @return 0 if it's work and 1 if the workers can't be started or failed
+ */
+int calculateProcesses(SweepState *state, const source_point *sources, size_t num_sources, double terminate,
+                       unsigned int n_iter, int processes, double *delta, unsigned long *sweeps);
+
+/**
+ * do n_iter row-major sweeps, blockSweeps of them at a time: a row is calculated for the next sweeps while it is
+ * still in the cache, in strips of blockCols columns when the rows are longer, in an order which ends with the same
+ * grid as the sweeps one by one (and the same sums as calculateOneTiled on one tile when there is one strip)
+ * @param state the sweep, with the sources grouped by row and a grid which is not cyclic
+ * @param n_iter number of sweeps
+ * @param delta set to the difference between the sums of the two last sweeps
+ * @return 0 if it's work and 1 if not
+ */
+int calculateTemporal(SweepState *state, unsigned int n_iter, double *delta);
+
+/**
+ * calculate the grid with V-cycles until the difference between the sums of two cycles is below terminate, the
+ * sweep of the call smoothing the grid
+ * @param state the sweep, with a grid with a ghost layer
+ * @param sweep the sweep
+ * @param sources list of the sources points
+ * @param num_sources number of sources
+ * @param terminate when terminate
+ * @param sum set to the sum of the points after the last sweep
+ * @param delta set to the difference between the sums of the two last cycles
+ * @return the number of sweeps of the grid done, 0 if the grid is too small or there is not enough memory
+ */
+unsigned long calculateMultigrid(SweepState *state, double (*sweep)(SweepState *), const source_point *sources,
+                                 size_t num_sources, double terminate, double *sum, double *delta);
+
+/**
+ * choose the size of the tiles for the tiled order from the sizes of the caches
+ * @param tileRows number of rows of a tile, kept if not 0
+ * @param tileCols number of columns of a tile, kept if not 0
+ */
+void chooseTile(size_t *tileRows, size_t *tileCols);
+
+/**
+ * choose the size of the tiles of calculateOneActive: small tiles, so the tiles far from the changes are skipped
+ * @param tileRows number of rows of a tile, kept if not 0
+ * @param tileCols number of columns of a tile, kept if not 0
+ */
+void chooseActiveTile(size_t *tileRows, size_t *tileCols);
+
+/**
+ * choose the over-relaxation factor of a grid, the optimal one for the average stencil: from the spectral radius rho of
+ * the Jacobi sweep of the grid, 2 / (1 + sqrt(1 - rho^2))
+ * @param omega the factor, kept if it is not OMEGA_AUTO
+ * @param n width of the grid
+ * @param m length of the grid
+ * @param is_cyclic 0 if it's not cyclic and cyclic otherwise
+ * @param stencil STENCIL_*, the weighted stencil keeps half of the point so its sweep converges slower
+ * @return the factor
+ */
+double chooseOmega(double omega, size_t n, size_t m, int is_cyclic, int stencil);
+
+/**
+ * choose the number of rows of the bands a mapped grid is streamed in: large enough for the reads and the writes of the
+ * disk to be long, small enough for a few bands to stay in the memory
+ * @param rows number of rows of a band, kept if not 0
+ * @param rowBytes size of a row of the grid in bytes
+ */
+void chooseStreamRows(size_t *rows, size_t rowBytes);
+
+/**
+ * choose the width of the strips of calculateTemporal from the size of L2
+ * @param blockCols set to the width of a strip, m for full rows
+ * @param blockSweeps number of sweeps of a block
+ * @param m length of the grid
+ * @param diagonals 1 if the stencil reads the diagonals and 0 if not
+ */
+void chooseBlockCols(size_t *blockCols, size_t blockSweeps, size_t m, int diagonals);
+
+#endif //SWEEP_H
@@ -0,0 +1,226 @@
+/**
+ * @file writer.c
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief print the grids of the calls on a writer thread while the next call is calculated
+ */
+#define _POSIX_C_SOURCE 200112L
+
+// ------------------------------ includes --------------------------------
+#include <pthread.h>
+#include <string.h>
+#include "reader.h"
+#include "writer.h"
+
+// ------------------------------ functions -------------------------------
+/**
+ * print a grid as text or as a frame
+ * @param writer the writer
+ * @param grid the grid, NULL if it is single
+ * @param single the float grid, NULL if it is grid
+ * @param delta the delta
+ */
+static void printAny(GridWriter *writer, const Grid *grid, const FloatGrid *single, double delta)
+{
+    if (writer->image != NULL && grid != NULL)
+    {
+        printImage(writer->out, writer->image, grid, delta);
+    }
+    else if (writer->image != NULL)
+    {
+        printFloatImage(writer->out, writer->image, single, delta);
+    }
+    else if (grid != NULL)
+    {
+        printGrid(writer->out, grid, delta);
+    }
+    else
+    {
+        printFloatGrid(writer->out, single, delta);
+    }
+}
+
+/**
+ * body of the writer thread: print the copies as they come, until stop
+ * @param arg the writer
+ * @return NULL
+ */
+static void *writerMain(void *arg)
+{
+    GridWriter *writer = (GridWriter *) arg;
+    pthread_mutex_lock(&writer->lock);
+    for (;;)
+    {
+        while (!writer->pending && !writer->stop)
+        {
+            pthread_cond_wait(&writer->changed, &writer->lock);
+        }
+        if (!writer->pending)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&writer->lock); // the caller only touches the copy once pending is 0
+        if (writer->isFloat)
+        {
+            printAny(writer, NULL, &writer->single, writer->delta);
+        }
+        else
+        {
+            printAny(writer, &writer->snapshot, NULL, writer->delta);
+        }
+        pthread_mutex_lock(&writer->lock);
+        writer->pending = 0;
+        pthread_cond_broadcast(&writer->changed);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+/**
+ * start a writer on an output
+ * @param writer the writer
+ * @param out the output
+ * @param image the frames to print the grids as, NULL to print them as text
+ * @param threaded 1 to print on a writer thread and 0 to print in writeGrid
+ */
+void openWriter(GridWriter *writer, Output *out, ImageStream *image, int threaded)
+{
+    writer->out = out;
+    writer->image = image;
+    writer->threaded = 0;
+    writer->snapshot.block = NULL;
+    writer->single.block = NULL;
+    writer->pending = 0;
+    writer->stop = 0;
+    if (!threaded)
+    {
+        return;
+    }
+    if (pthread_mutex_init(&writer->lock, NULL) != 0)
+    {
+        return;
+    }
+    if (pthread_cond_init(&writer->changed, NULL) != 0)
+    {
+        pthread_mutex_destroy(&writer->lock);
+        return;
+    }
+    if (pthread_create(&writer->thread, NULL, writerMain, writer) != 0)
+    { // the grids are printed by the caller
+        pthread_cond_destroy(&writer->changed);
+        pthread_mutex_destroy(&writer->lock);
+        return;
+    }
+    writer->threaded = 1;
+}
+
+/**
+ * wait until the writer thread has printed the last copy
+ * @param writer the writer
+ */
+static void waitPrinted(GridWriter *writer)
+{
+    pthread_mutex_lock(&writer->lock);
+    while (writer->pending)
+    {
+        pthread_cond_wait(&writer->changed, &writer->lock);
+    }
+    pthread_mutex_unlock(&writer->lock);
+}
+
+/**
+ * give the copy to the writer thread
+ * @param writer the writer
+ * @param isFloat 1 if the copy is single and 0 if it is snapshot
+ * @param delta the delta
+ */
+static void handOver(GridWriter *writer, int isFloat, double delta)
+{
+    pthread_mutex_lock(&writer->lock);
+    writer->isFloat = isFloat;
+    writer->delta = delta;
+    writer->pending = 1;
+    pthread_cond_broadcast(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+/**
+ * print the delta value and the grid like printGrid, on the writer thread if there is one
+ * The grid is copied row by row into a grid of the same size kept from one call to the next. The copy is much faster
+ * than the printing, which is done while the caller goes on. If there is not enough memory for it, or if the grid is
+ * mapped from a file (mapGrid, a copy in memory is what the mapping avoids), the grid is printed right away.
+ * @param writer the writer
+ * @param grid the grid, which the caller may change once this returns
+ * @param delta the delta
+ */
+void writeGrid(GridWriter *writer, const Grid *grid, double delta)
+{
+    if (!writer->threaded)
+    {
+        printAny(writer, grid, NULL, delta);
+        return;
+    }
+    waitPrinted(writer);
+    Grid *copy = &writer->snapshot;
+    if (grid->mapped > 0 ||
+        ((copy->block == NULL || copy->n != grid->n || copy->m != grid->m) && resizeGrid(copy, grid->n, grid->m)))
+    {
+        printAny(writer, grid, NULL, delta);
+        return;
+    }
+    for (size_t x = 0; x < grid->n; ++x)
+    {
+        memcpy(GRID_ROW(copy, x), GRID_ROW(grid, x), sizeof(double) * grid->m);
+    }
+    handOver(writer, 0, delta);
+}
+
+/**
+ * print the delta value and a float grid like printFloatGrid, on the writer thread if there is one
+ * @param writer the writer
+ * @param grid the grid, which the caller may change once this returns
+ * @param delta the delta
+ */
+void writeFloatGrid(GridWriter *writer, const FloatGrid *grid, double delta)
+{
+    if (!writer->threaded)
+    {
+        printAny(writer, NULL, grid, delta);
+        return;
+    }
+    waitPrinted(writer);
+    FloatGrid *copy = &writer->single;
+    if ((copy->block == NULL || copy->n != grid->n || copy->m != grid->m) &&
+        resizeFloatGrid(copy, grid->n, grid->m))
+    {
+        printAny(writer, NULL, grid, delta);
+        return;
+    }
+    for (size_t x = 0; x < grid->n; ++x)
+    {
+        memcpy(GRID_ROW(copy, x), GRID_ROW(grid, x), sizeof(float) * grid->m);
+    }
+    handOver(writer, 1, delta);
+}
+
+/**
+ * wait until the last grid is printed, stop the writer thread and free the copies
+ * @param writer the writer
+ */
+void closeWriter(GridWriter *writer)
+{
+    if (writer->threaded)
+    {
+        pthread_mutex_lock(&writer->lock);
+        writer->stop = 1;
+        pthread_cond_broadcast(&writer->changed);
+        pthread_mutex_unlock(&writer->lock);
+        pthread_join(writer->thread, NULL);
+        pthread_cond_destroy(&writer->changed);
+        pthread_mutex_destroy(&writer->lock);
+        writer->threaded = 0;
+    }
+    freeGrid(&writer->snapshot);
+    freeFloatGrid(&writer->single);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file writer.h
+ * @author  Dan Boujenah
+ * @version 1.0
+ * @date 25 Aug 2018
+ * @brief print the grids of the calls on a writer thread while the next call is calculated
+ */
+#ifndef WRITER_H
+#define WRITER_H
+
+// ------------------------------ includes --------------------------------
+#include <pthread.h>
+#include "grid.h"
+#include "image.h"
+#include "output.h"
+
+/**
+ * The writer of the grids of a run. With a thread, writeGrid copies the grid to snapshot (or single for a float grid)
+ * and returns, the thread prints the copy while the caller calculates the next grid. The next writeGrid waits until
+ * the copy is printed, so the grids come out in their order and each one as printGrid prints it. pending tells that
+ * a copy waits to be printed, stop that the thread has to end once it is.
+ * Without a thread (threaded == 0, or if it can't be started), writeGrid is printGrid, and so it is for a grid mapped
+ * from a file. With image not NULL, the grids
+ * are printed as its frames (printImage) instead of text.
+ */
+typedef struct GridWriter
+{
+    Output *out;
+    ImageStream *image;
+    int threaded;
+    Grid snapshot;
+    FloatGrid single;
+    int isFloat;
+    double delta;
+    int pending;
+    int stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} GridWriter;
+
+// ------------------------------ functions -------------------------------
+/**
+ * start a writer on an output
+ * @param writer the writer
+ * @param out the output
+ * @param image the frames to print the grids as, NULL to print them as text
+ * @param threaded 1 to print on a writer thread and 0 to print in writeGrid
+ */
+void openWriter(GridWriter *writer, Output *out, ImageStream *image, int threaded);
+
+/**
+ * print the delta value and the grid like printGrid, on the writer thread if there is one
+ * @param writer the writer
+ * @param grid the grid, which the caller may change once this returns
+ * @param delta the delta
+ */
+void writeGrid(GridWriter *writer, const Grid *grid, double delta);
+
+/**
+ * print the delta value and a float grid like printFloatGrid, on the writer thread if there is one
+ * @param writer the writer
+ * @param grid the grid, which the caller may change once this returns
+ * @param delta the delta
+ */
+void writeFloatGrid(GridWriter *writer, const FloatGrid *grid, double delta);
+
+/**
+ * wait until the last grid is printed, stop the writer thread and free the copies (the output stays open)
+ * @param writer the writer
+ */
+void closeWriter(GridWriter *writer);
+
+#endif //WRITER_H